@@ -0,0 +1,62 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__ACTION_CHUNKER_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__ACTION_CHUNKER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+// Executes policies that predict K future actions per forward pass ([K, action_size] output).
+// A new chunk is requested every `execution_horizon` ticks. With temporal ensembling enabled
+// all stored chunks that cover the current tick are averaged with weights exp(-decay * i),
+// where i = 0 is the oldest prediction.
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC ActionChunker
+{
+public:
+  ActionChunker(
+    size_t chunk_size, size_t action_size, size_t execution_horizon,
+    bool temporal_ensemble, double ensemble_decay);
+  bool needsInference() const;
+  void pushChunk(const float * chunk, size_t size);
+  void nextAction(std::vector<float> & action);
+  void reset();
+  size_t chunkSize() const;
+  size_t actionSize() const;
+
+private:
+  size_t chunk_size_;
+  size_t action_size_;
+  size_t execution_horizon_;
+  bool temporal_ensemble_;
+  double ensemble_decay_;
+  // Ring of stored chunks, preallocated so the control loop never allocates
+  size_t max_chunks_;
+  size_t head_ = 0;
+  size_t count_ = 0;
+  uint64_t tick_ = 0;
+  uint64_t last_push_tick_ = 0;
+  std::vector<float> chunks_;
+  std::vector<uint64_t> start_ticks_;
+  std::vector<double> accumulator_;
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__ACTION_CHUNKER_HPP_
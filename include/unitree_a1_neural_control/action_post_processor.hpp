@@ -0,0 +1,106 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__ACTION_POST_PROCESSOR_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__ACTION_POST_PROCESSOR_HPP_
+
+#include <Eigen/Dense>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "unitree_a1_neural_control/low_cmd_writer.hpp"
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+enum class OutputHead : uint8_t
+{
+  POSITION = 0,
+  KP = 1,
+  KD = 2,
+  TAU = 3
+};
+constexpr size_t OUTPUT_HEAD_COUNT = 4;
+// Upper bounds of policy-predicted gains, twice the usual locomotion gains
+constexpr float MAX_HEAD_KP = 100.0f;
+constexpr float MAX_HEAD_KD = 10.0f;
+
+// One block of JOINT_COUNT policy outputs, mapped to head value = clamp(raw * scale, min, max).
+// Position targets additionally get the nominal joint position added before clamping. The
+// configured range is narrowed to the joint limits for positions, [0, MAX_HEAD_KP] and
+// [0, MAX_HEAD_KD] for gains and +-Robot::MAX_TORQUE for torque, so the unset range of a head
+// is exactly that bound.
+struct OutputHeadConfig
+{
+  OutputHead head;
+  float scale;
+  float min = -std::numeric_limits<float>::infinity();
+  float max = std::numeric_limits<float>::infinity();
+};
+
+// Safety bounds of the position targets, in radians. max_step limits the change of each target
+// per tick, 0 disables it.
+struct JointLimits
+{
+  JointArray lower;
+  JointArray upper;
+  float max_step = 0.0f;
+  static JointLimits unlimited()
+  {
+    JointLimits limits;
+    limits.lower.fill(-std::numeric_limits<float>::infinity());
+    limits.upper.fill(std::numeric_limits<float>::infinity());
+    return limits;
+  }
+};
+
+// Turns the raw policy action, the configured heads concatenated in order, into joint
+// targets and gains. Scaling, nominal offset, head and joint limits, rate limiting and NaN
+// scrubbing run in one fused, vectorized pass. A non-finite raw value holds the previous
+// output, before the first tick the nominal position and zero gains.
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC ActionPostProcessor
+{
+public:
+  // Position head only, unit scale, no nominal offset
+  ActionPostProcessor();
+  ActionPostProcessor(
+    const std::vector<OutputHeadConfig> & heads, const JointArray & nominal,
+    const JointLimits & limits = JointLimits::unlimited());
+  void process(const float * raw);
+  // Back to the nominal pose, which the next tick is rate limited from
+  void reset();
+  // Processed values of `head`, nullptr when the policy does not output it
+  const float * output(OutputHead head) const;
+  // Offset of `head` in the raw action, only valid for configured heads
+  size_t offset(OutputHead head) const;
+  size_t actionSize() const;
+
+private:
+  std::array<int, OUTPUT_HEAD_COUNT> head_index_;
+  Eigen::ArrayXf scale_;
+  Eigen::ArrayXf offset_;
+  Eigen::ArrayXf lower_;
+  Eigen::ArrayXf upper_;
+  // Per-tick step bound, infinite outside the position head
+  Eigen::ArrayXf step_;
+  Eigen::ArrayXf output_;
+  Eigen::ArrayXf previous_;
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__ACTION_POST_PROCESSOR_HPP_
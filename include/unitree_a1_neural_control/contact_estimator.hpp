@@ -0,0 +1,72 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__CONTACT_ESTIMATOR_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__CONTACT_ESTIMATOR_HPP_
+
+#include <array>
+#include <cstdint>
+#include "unitree_a1_neural_control/robot_description.hpp"
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+// One value per foot in message field order: FR, FL, RR, RL
+using FootArray = std::array<float, Robot::LEG_COUNT>;
+
+struct ContactEstimatorConfig
+{
+  // Filtered force that puts a foot into contact
+  FootArray on_threshold;
+  // Filtered force below which a foot leaves contact, at most on_threshold
+  FootArray off_threshold;
+  // Low-pass weight of a new sample, 1 disables filtering
+  float alpha = 1.0f;
+  // Same threshold for every foot, no hysteresis and no filtering
+  static ContactEstimatorConfig uniform(float threshold)
+  {
+    ContactEstimatorConfig config;
+    config.on_threshold.fill(threshold);
+    config.off_threshold.fill(threshold);
+    return config;
+  }
+  // Throws std::invalid_argument for a weight outside (0, 1] or an inverted threshold pair
+  void validate() const;
+};
+
+// Contact flags from raw foot force, updated at the sensor rate. Every foot is one lane of a
+// branch-free kernel: exponential low-pass filter, then a Schmitt trigger between the off and
+// on thresholds.
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC ContactEstimator
+{
+public:
+  explicit ContactEstimator(
+    const ContactEstimatorConfig & config = ContactEstimatorConfig::uniform(20.0f));
+  void setConfig(const ContactEstimatorConfig & config);
+  void update(const FootArray & force);
+  // 1 for feet in contact, 0 otherwise
+  const FootArray & contact() const;
+  const FootArray & filtered() const;
+  void reset();
+
+private:
+  ContactEstimatorConfig config_;
+  FootArray filtered_{};
+  FootArray contact_{};
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__CONTACT_ESTIMATOR_HPP_
@@ -0,0 +1,77 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__GENERATED_POLICY_KERNEL_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__GENERATED_POLICY_KERNEL_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include "unitree_a1_neural_control/policy_backend.hpp"
+
+// Building blocks of the kernels emitted by scripts/generate_policy_kernel.py. Layer sizes are
+// template parameters, so the compiler sees every loop bound and can unroll and vectorize.
+namespace unitree_a1_neural_control
+{
+namespace generated
+{
+
+enum class Activation
+{
+  IDENTITY,
+  RELU,
+  ELU,
+  TANH
+};
+
+template<Activation A>
+inline float activate(float x)
+{
+  switch (A) {
+    case Activation::RELU:
+      return x > 0.0f ? x : 0.0f;
+    case Activation::ELU:
+      return x > 0.0f ? x : std::expm1(x);
+    case Activation::TANH:
+      return std::tanh(x);
+    default:
+      return x;
+  }
+}
+
+// output = activation(W * input + bias) with W stored transposed, [IN][OUT], so the inner
+// loop runs over contiguous outputs and vectorizes without reassociating the sums
+template<Activation A, size_t IN, size_t OUT>
+inline void dense(
+  const float (&weight_t)[IN][OUT], const float (&bias)[OUT],
+  const float * __restrict__ input, float * __restrict__ output)
+{
+  alignas(64) float acc[OUT];
+  for (size_t o = 0; o < OUT; o++) {
+    acc[o] = bias[o];
+  }
+  for (size_t i = 0; i < IN; i++) {
+    const float x = input[i];
+    for (size_t o = 0; o < OUT; o++) {
+      acc[o] += weight_t[i][o] * x;
+    }
+  }
+  for (size_t o = 0; o < OUT; o++) {
+    output[o] = activate<A>(acc[o]);
+  }
+}
+
+}  // namespace generated
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__GENERATED_POLICY_KERNEL_HPP_
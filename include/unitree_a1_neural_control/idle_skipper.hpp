@@ -0,0 +1,62 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__IDLE_SKIPPER_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__IDLE_SKIPPER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+struct InferenceStats
+{
+  uint64_t forwards = 0;
+  uint64_t skipped = 0;
+  double mean_forward_ms = 0.0;
+  double saved_ms = 0.0;
+};
+
+// Detects steady state (zero goal velocity and an observation that stays within
+// `observation_threshold` of the one used for the last forward) so the last action can be
+// reused. A forward is still forced every `keep_alive_ticks` ticks.
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC IdleSkipper
+{
+public:
+  IdleSkipper(
+    bool enabled, double observation_threshold, double goal_threshold,
+    size_t keep_alive_ticks, size_t goal_index);
+  bool shouldSkip(const std::vector<float> & state);
+  void recordInference(const std::vector<float> & state, double forward_ms);
+  InferenceStats getStats() const;
+  void reset();
+
+private:
+  bool enabled_;
+  double observation_threshold_;
+  double goal_threshold_;
+  size_t keep_alive_ticks_;
+  size_t goal_index_;
+  size_t ticks_since_inference_ = 0;
+  bool has_reference_ = false;
+  std::vector<float> reference_state_;
+  InferenceStats stats_;
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__IDLE_SKIPPER_HPP_
@@ -0,0 +1,58 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__INFERENCE_WORKER_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__INFERENCE_WORKER_HPP_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+// Pins `thread` to `cpu` (-1 keeps the default placement) and optionally moves it to the
+// SCHED_IDLE class so it only gets CPU time the control thread does not use.
+UNITREE_A1_NEURAL_CONTROL_PUBLIC void configureWorkerThread(
+  std::thread & thread, int cpu, bool low_priority);
+
+// Persistent thread that runs one job at a time next to the control thread.
+// `cpu` pins the thread to a core, -1 leaves placement to the scheduler.
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC InferenceWorker
+{
+public:
+  explicit InferenceWorker(int cpu = -1);
+  ~InferenceWorker();
+  InferenceWorker(const InferenceWorker &) = delete;
+  InferenceWorker & operator=(const InferenceWorker &) = delete;
+  void submit(std::function<void()> job);
+  void wait();
+
+private:
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::function<void()> job_;
+  std::exception_ptr error_;
+  bool busy_ = false;
+  bool stop_ = false;
+  void run();
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__INFERENCE_WORKER_HPP_
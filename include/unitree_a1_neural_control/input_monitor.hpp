@@ -0,0 +1,82 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__INPUT_MONITOR_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__INPUT_MONITOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+// Statistics of one input stream over a report window, times in milliseconds
+struct InputHealth
+{
+  static constexpr size_t FIELD_COUNT = 7;
+  double rate_hz = 0.0;
+  // Standard deviation of the inter-arrival time
+  double jitter_ms = 0.0;
+  // Longest inter-arrival time, including the gap still open at the end of the window
+  double max_gap_ms = 0.0;
+  // Receive time minus header stamp
+  double mean_delay_ms = 0.0;
+  double max_delay_ms = 0.0;
+  uint64_t received = 0;
+  // Messages the synchronizer never paired, since start. Up to its queue depth of messages
+  // still waiting for a partner count as dropped until they are paired.
+  uint64_t dropped = 0;
+};
+
+// Receive age in milliseconds, infinite before the first message
+UNITREE_A1_NEURAL_CONTROL_PUBLIC double receiveAgeMs(int64_t now_ns, int64_t receive_ns);
+// Safe mode condition, an age past its timeout in seconds. A timeout of 0 disables its check.
+UNITREE_A1_NEURAL_CONTROL_PUBLIC bool inputsStale(
+  double state_age_ms, double cmd_vel_age_ms, double state_timeout, double cmd_vel_timeout);
+
+// Per-stream counters updated in O(1) from the subscription callbacks, summarized and reset
+// once per report window
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC InputMonitor
+{
+public:
+  // `synchronized` streams feed the synchronizer and count its drops
+  explicit InputMonitor(bool synchronized = false);
+  void reset(int64_t now_ns);
+  // A message received at `receive_ns`, `stamp_ns` 0 for messages without a stamp
+  void received(int64_t receive_ns, int64_t stamp_ns);
+  // A message passed on by the synchronizer
+  void synchronized();
+  // Closes the window at `now_ns` and starts the next one
+  InputHealth report(int64_t now_ns);
+
+private:
+  bool synchronized_;
+  int64_t window_start_ns_ = 0;
+  int64_t last_receive_ns_ = 0;
+  uint64_t window_count_ = 0;
+  uint64_t interval_count_ = 0;
+  double interval_sum_ms_ = 0.0;
+  double interval_sq_sum_ms_ = 0.0;
+  double max_gap_ms_ = 0.0;
+  uint64_t delay_count_ = 0;
+  double delay_sum_ms_ = 0.0;
+  double max_delay_ms_ = 0.0;
+  uint64_t received_total_ = 0;
+  uint64_t synchronized_total_ = 0;
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__INPUT_MONITOR_HPP_
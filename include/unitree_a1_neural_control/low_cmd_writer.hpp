@@ -0,0 +1,46 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__LOW_CMD_WRITER_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__LOW_CMD_WRITER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unitree_a1_legged_msgs/msg/low_cmd.hpp>
+#include "unitree_a1_neural_control/robot_description.hpp"
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+constexpr size_t JOINT_COUNT = Robot::JOINT_COUNT;
+using JointArray = Robot::JointArray;
+// LowCmd holds four legs of three motors
+static_assert(Robot::LEG_COUNT == 4 && Robot::JOINTS_PER_LEG == 3, "Unsupported robot layout");
+using MotorCmdTable = std::array<unitree_a1_legged_msgs::msg::MotorCmd *, JOINT_COUNT>;
+using JointGather = std::array<uint8_t, JOINT_COUNT>;
+
+// Motor commands of `cmd` in message field order: FR, FL, RR, RL legs, each hip, thigh, calf
+UNITREE_A1_NEURAL_CONTROL_PUBLIC MotorCmdTable motorCmdTable(
+  unitree_a1_legged_msgs::msg::LowCmd & cmd);
+
+// Fills mode, q, dq = 0, kp, kd and tau of all twelve motors in one pass over the table.
+// Every array holds JOINT_COUNT values in action order, action joint i drives motor joints[i].
+UNITREE_A1_NEURAL_CONTROL_PUBLIC void writeMotorCmds(
+  unitree_a1_legged_msgs::msg::LowCmd & cmd, uint8_t mode, const JointGather & joints,
+  const float * q, const float * kp, const float * kd, const float * tau);
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__LOW_CMD_WRITER_HPP_
@@ -0,0 +1,87 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__NATIVE_POLICY_BACKEND_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__NATIVE_POLICY_BACKEND_HPP_
+
+#include <Eigen/Dense>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "unitree_a1_neural_control/policy_backend.hpp"
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+// Native weight file (.npw), little endian, written by scripts/generate_policy_kernel.py:
+//   NativeWeightsHeader
+//   NativeLayerHeader[layer_count]
+//   float32 tensors, each starting at a NATIVE_WEIGHTS_ALIGNMENT aligned offset,
+//   weights row-major [out][in]
+constexpr char NATIVE_WEIGHTS_MAGIC[8] = {'A', '1', 'P', 'O', 'L', 'I', 'C', 'Y'};
+constexpr uint32_t NATIVE_WEIGHTS_VERSION = 1;
+constexpr size_t NATIVE_WEIGHTS_ALIGNMENT = 64;
+constexpr uint32_t NATIVE_ACTIVATION_COUNT = 4;
+
+struct NativeWeightsHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t layer_count;
+  uint32_t observation_size;
+  uint32_t action_size;
+  uint8_t reserved[40];
+};
+
+struct NativeLayerHeader
+{
+  uint32_t out_features;
+  uint32_t in_features;
+  // 0 identity, 1 relu, 2 elu, 3 tanh, anything else is rejected
+  uint32_t activation;
+  uint32_t reserved;
+  uint64_t weight_offset;
+  uint64_t bias_offset;
+};
+
+// Eigen MLP evaluated in place from a memory-mapped native weight file, no libtorch needed
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC NativePolicyBackend : public PolicyBackend
+{
+public:
+  NativePolicyBackend(const std::string & filepath, size_t observation_size);
+  void forward(const float * observation, float * action) override;
+  size_t observationSize() const override;
+  size_t actionSize() const override;
+
+private:
+  struct Layer
+  {
+    Eigen::Map<const Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>,
+      Eigen::Aligned64> weight;
+    Eigen::Map<const Eigen::VectorXf, Eigen::Aligned64> bias;
+    uint32_t activation;
+  };
+  size_t observation_size_;
+  size_t action_size_;
+  // Page aligned read-only mapping of the file, tensor offsets keep their alignment
+  std::shared_ptr<void> storage_;
+  std::vector<Layer> layers_;
+  std::vector<Eigen::VectorXf> buffers_;
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__NATIVE_POLICY_BACKEND_HPP_
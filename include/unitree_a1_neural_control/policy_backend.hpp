@@ -0,0 +1,75 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__POLICY_BACKEND_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__POLICY_BACKEND_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+constexpr size_t POLICY_WARMUP_ITERATIONS = 10;
+// Bumped whenever the PolicyBackend layout changes, plugins built against another version
+// are rejected
+constexpr uint32_t POLICY_BACKEND_ABI_VERSION = 1;
+
+// Inference backend of a single policy. `forward` maps one observation of observationSize()
+// floats to actionSize() floats (K * 12 for chunking policies). Implementations do not need
+// to be reentrant, but different instances may run concurrently.
+class PolicyBackend
+{
+public:
+  virtual ~PolicyBackend() = default;
+  virtual void forward(const float * observation, float * action) = 0;
+  virtual size_t observationSize() const = 0;
+  virtual size_t actionSize() const = 0;
+};
+
+using PolicyBackendPtr = std::unique_ptr<PolicyBackend>;
+
+// Creates the backend matching the policy file:
+//   .so  - generated kernel plugin (see scripts/generate_policy_kernel.py)
+//   .npw - native weight file evaluated with Eigen
+//   else - TorchScript module, served by the torch backend plugin mapped on first use
+UNITREE_A1_NEURAL_CONTROL_PUBLIC PolicyBackendPtr loadPolicyBackend(
+  const std::string & filepath, size_t observation_size);
+
+}  // namespace unitree_a1_neural_control
+
+// Entry points exported by policy backend plugins
+extern "C" {
+using CreatePolicyBackendFn = unitree_a1_neural_control::PolicyBackend * (*)(
+  const char * filepath, size_t observation_size);
+using PolicyBackendAbiFn = uint32_t (*)();
+}
+
+// Exports `BackendClass`, constructible from (const std::string & filepath,
+// size_t observation_size), as a policy backend plugin
+#define UNITREE_A1_NEURAL_CONTROL_EXPORT_POLICY_BACKEND(BackendClass) \
+  extern "C" UNITREE_A1_NEURAL_CONTROL_PUBLIC uint32_t \
+  unitree_a1_neural_control_policy_backend_abi() \
+  { \
+    return unitree_a1_neural_control::POLICY_BACKEND_ABI_VERSION; \
+  } \
+  extern "C" UNITREE_A1_NEURAL_CONTROL_PUBLIC unitree_a1_neural_control::PolicyBackend * \
+  unitree_a1_neural_control_create_policy_backend(const char * filepath, size_t observation_size) \
+  { \
+    return new BackendClass(filepath, observation_size); \
+  }
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__POLICY_BACKEND_HPP_
@@ -0,0 +1,71 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__POLICY_BANK_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__POLICY_BANK_HPP_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "unitree_a1_neural_control/inference_worker.hpp"
+#include "unitree_a1_neural_control/policy_backend.hpp"
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+// Set of policies loaded, optimized and warmed up at startup. Selection may be requested
+// from any thread and is applied by the control thread at the start of the next tick.
+// With crossfade enabled the previous policy keeps running on a worker thread for
+// `crossfade_ticks` forwards and the outputs are blended linearly towards the new policy.
+// A selection made during a crossfade is applied once it completes.
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC PolicyBank
+{
+public:
+  explicit PolicyBank(size_t observation_size);
+  void add(const std::string & name, const std::string & path);
+  void reload();
+  void setCrossfade(size_t crossfade_ticks, int cpu);
+  bool inTransition() const;
+  bool select(const std::string & name);
+  bool applySelection();
+  const std::vector<float> & forward(const std::vector<float> & state);
+  std::string activeName() const;
+  std::vector<std::string> names() const;
+  size_t size() const;
+
+private:
+  struct Policy
+  {
+    std::string name;
+    std::string path;
+    PolicyBackendPtr backend;
+    std::vector<float> action;
+  };
+  size_t observation_size_;
+  std::vector<Policy> policies_;
+  std::atomic<size_t> requested_{0};
+  size_t active_ = 0;
+  size_t previous_ = 0;
+  size_t crossfade_ticks_ = 0;
+  size_t crossfade_remaining_ = 0;
+  bool started_ = false;
+  std::unique_ptr<InferenceWorker> worker_;
+  void load(Policy & policy);
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__POLICY_BANK_HPP_
@@ -0,0 +1,53 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__POLICY_CACHE_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__POLICY_CACHE_HPP_
+
+#include <cstdint>
+#include <string>
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+struct PolicyLoadStats
+{
+  uint64_t loads = 0;
+  uint64_t cache_hits = 0;
+  uint64_t cache_misses = 0;
+  double last_load_ms = 0.0;
+  // Totals over all loads, optimize and warm-up are part of the load time
+  double total_load_ms = 0.0;
+  double total_optimize_ms = 0.0;
+  double total_warmup_ms = 0.0;
+};
+
+// Process wide cache of optimized policy artifacts. Entries are keyed by the FNV-1a hash of
+// the policy file together with the runtime that produced them, so editing the model or
+// upgrading the runtime never serves a stale artifact. An empty directory disables caching.
+UNITREE_A1_NEURAL_CONTROL_PUBLIC void setPolicyCacheDirectory(const std::string & directory);
+UNITREE_A1_NEURAL_CONTROL_PUBLIC std::string getPolicyCacheDirectory();
+UNITREE_A1_NEURAL_CONTROL_PUBLIC uint64_t hashPolicyFile(const std::string & filepath);
+// Path of the cached artifact of `filepath` built by `runtime`, empty when caching is disabled
+UNITREE_A1_NEURAL_CONTROL_PUBLIC std::string policyCachePath(
+  const std::string & filepath, const std::string & runtime);
+UNITREE_A1_NEURAL_CONTROL_PUBLIC void recordPolicyCacheLookup(bool hit);
+UNITREE_A1_NEURAL_CONTROL_PUBLIC void recordPolicyLoad(double load_ms, double warmup_ms);
+UNITREE_A1_NEURAL_CONTROL_PUBLIC void recordPolicyOptimize(double optimize_ms);
+UNITREE_A1_NEURAL_CONTROL_PUBLIC PolicyLoadStats getPolicyLoadStats();
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__POLICY_CACHE_HPP_
@@ -0,0 +1,80 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__POLICY_ENSEMBLE_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__POLICY_ENSEMBLE_HPP_
+
+#include <Eigen/Dense>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "unitree_a1_neural_control/inference_worker.hpp"
+#include "unitree_a1_neural_control/policy_backend.hpp"
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+enum class EnsembleMode
+{
+  // One model per member, members run concurrently on worker threads
+  PARALLEL,
+  // A single model whose output holds all members, [M, ...]
+  BATCHED
+};
+
+enum class EnsembleReduction
+{
+  MEAN,
+  MEDIAN
+};
+
+// Evaluates M policy variants on the same observation and reduces their outputs to a single
+// action. The per-element standard deviation across members is kept as an uncertainty signal.
+// In the parallel mode member 0 runs on the control thread and member i on worker i - 1,
+// pinned to `cpus[i - 1]` when given.
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC PolicyEnsemble
+{
+public:
+  PolicyEnsemble(
+    const std::vector<std::string> & filepaths, size_t observation_size,
+    EnsembleMode mode, size_t batched_size, EnsembleReduction reduction,
+    const std::vector<int> & cpus = {});
+  const std::vector<float> & forward(const std::vector<float> & state);
+  const std::vector<float> & getSpread() const;
+  size_t size() const;
+
+private:
+  EnsembleMode mode_;
+  EnsembleReduction reduction_;
+  size_t members_count_;
+  size_t action_size_;
+  std::vector<PolicyBackendPtr> backends_;
+  std::vector<std::unique_ptr<InferenceWorker>> workers_;
+  // One job per worker built at construction, they read the observation through state_
+  std::vector<std::function<void()>> jobs_;
+  const float * state_ = nullptr;
+  // Member outputs, one row per member
+  Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> members_;
+  Eigen::RowVectorXf mean_;
+  std::vector<float> column_;
+  std::vector<float> action_;
+  std::vector<float> spread_;
+  void gather(const std::vector<float> & state);
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__POLICY_ENSEMBLE_HPP_
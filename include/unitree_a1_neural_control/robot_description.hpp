@@ -0,0 +1,171 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__ROBOT_DESCRIPTION_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__ROBOT_DESCRIPTION_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace unitree_a1_neural_control
+{
+
+// Legs in LowState and LowCmd field order
+enum class Leg : uint8_t
+{
+  FRONT_RIGHT = 0,
+  FRONT_LEFT = 1,
+  REAR_RIGHT = 2,
+  REAR_LEFT = 3
+};
+// Leg of every slot in a per-leg block of the policy input or output
+template<size_t LegCount>
+using LegOrder = std::array<Leg, LegCount>;
+
+// Slot i of a per-leg block reads element gather[i] of a per-leg array in field order
+template<size_t LegCount>
+constexpr std::array<uint8_t, LegCount> legGather(const LegOrder<LegCount> & order)
+{
+  std::array<uint8_t, LegCount> gather{};
+  for (size_t i = 0; i < LegCount; i++) {
+    gather[i] = static_cast<uint8_t>(order[i]);
+  }
+  return gather;
+}
+
+// Same for per-joint blocks, joints of a leg stay in hip, thigh, calf order
+template<size_t JointsPerLeg, size_t LegCount>
+constexpr std::array<uint8_t, LegCount * JointsPerLeg> jointGather(
+  const LegOrder<LegCount> & order)
+{
+  std::array<uint8_t, LegCount * JointsPerLeg> gather{};
+  for (size_t i = 0; i < LegCount; i++) {
+    for (size_t j = 0; j < JointsPerLeg; j++) {
+      gather[i * JointsPerLeg + j] = static_cast<uint8_t>(
+        static_cast<size_t>(order[i]) * JointsPerLeg + j);
+    }
+  }
+  return gather;
+}
+
+// Sizes and observation layout of a legged robot, fixed at compile time
+template<size_t LegCount, size_t JointsPerLeg>
+struct RobotLayout
+{
+  static constexpr size_t LEG_COUNT = LegCount;
+  static constexpr size_t JOINTS_PER_LEG = JointsPerLeg;
+  static constexpr size_t JOINT_COUNT = LegCount * JointsPerLeg;
+  // Observation layout
+  static constexpr size_t OBS_JOINT_POSITION = 0;
+  static constexpr size_t OBS_ANGULAR_VELOCITY = OBS_JOINT_POSITION + JOINT_COUNT;
+  static constexpr size_t OBS_JOINT_VELOCITY = OBS_ANGULAR_VELOCITY + 3;
+  static constexpr size_t OBS_GOAL_VELOCITY = OBS_JOINT_VELOCITY + JOINT_COUNT;
+  static constexpr size_t OBS_FOOT_CONTACT = OBS_GOAL_VELOCITY + 3;
+  static constexpr size_t OBS_GRAVITY = OBS_FOOT_CONTACT + LEG_COUNT;
+  static constexpr size_t OBS_LAST_ACTION = OBS_GRAVITY + 3;
+  static constexpr size_t OBS_CYCLES_SINCE_CONTACT = OBS_LAST_ACTION + JOINT_COUNT;
+  static constexpr size_t OBS_SIZE = OBS_CYCLES_SINCE_CONTACT + LEG_COUNT;
+  using JointArray = std::array<float, JOINT_COUNT>;
+  using Legs = LegOrder<LEG_COUNT>;
+};
+
+// Default leg order of the trained policies. Joint blocks, the action included, are FR, FL,
+// RR, RL, foot contacts FL, FR, RL, RR and cycles since contact FR, FL, RR, RL.
+constexpr LegOrder<4> QUADRUPED_JOINT_ORDER{
+  Leg::FRONT_RIGHT, Leg::FRONT_LEFT, Leg::REAR_RIGHT, Leg::REAR_LEFT};
+constexpr LegOrder<4> QUADRUPED_CONTACT_ORDER{
+  Leg::FRONT_LEFT, Leg::FRONT_RIGHT, Leg::REAR_LEFT, Leg::REAR_RIGHT};
+constexpr LegOrder<4> QUADRUPED_CYCLE_ORDER{
+  Leg::FRONT_RIGHT, Leg::FRONT_LEFT, Leg::REAR_RIGHT, Leg::REAR_LEFT};
+
+// Joints in action order, each leg hip, thigh, calf. Limits in radians.
+struct A1Description : RobotLayout<4, 3>
+{
+  static constexpr const char * NAME = "a1";
+  static constexpr Legs JOINT_ORDER = QUADRUPED_JOINT_ORDER;
+  static constexpr Legs CONTACT_ORDER = QUADRUPED_CONTACT_ORDER;
+  static constexpr Legs CYCLE_ORDER = QUADRUPED_CYCLE_ORDER;
+  static constexpr JointArray NOMINAL{
+    -0.1f, 0.8f, -1.5f, 0.1f, 0.8f, -1.5f,
+    -0.1f, 1.0f, -1.5f, 0.1f, 1.0f, -1.5f};
+  static constexpr JointArray LOWER{
+    -0.802f, -1.047f, -2.697f, -0.802f, -1.047f, -2.697f,
+    -0.802f, -1.047f, -2.697f, -0.802f, -1.047f, -2.697f};
+  static constexpr JointArray UPPER{
+    0.802f, 4.189f, -0.916f, 0.802f, 4.189f, -0.916f,
+    0.802f, 4.189f, -0.916f, 0.802f, 4.189f, -0.916f};
+  // Peak motor torque in Nm, bounds policy-predicted torque
+  static constexpr float MAX_TORQUE = 33.5f;
+};
+
+struct Go1Description : RobotLayout<4, 3>
+{
+  static constexpr const char * NAME = "go1";
+  static constexpr Legs JOINT_ORDER = QUADRUPED_JOINT_ORDER;
+  static constexpr Legs CONTACT_ORDER = QUADRUPED_CONTACT_ORDER;
+  static constexpr Legs CYCLE_ORDER = QUADRUPED_CYCLE_ORDER;
+  static constexpr JointArray NOMINAL{
+    -0.1f, 0.8f, -1.5f, 0.1f, 0.8f, -1.5f,
+    -0.1f, 1.0f, -1.5f, 0.1f, 1.0f, -1.5f};
+  static constexpr JointArray LOWER{
+    -0.863f, -0.686f, -2.818f, -0.863f, -0.686f, -2.818f,
+    -0.863f, -0.686f, -2.818f, -0.863f, -0.686f, -2.818f};
+  static constexpr JointArray UPPER{
+    0.863f, 4.501f, -0.888f, 0.863f, 4.501f, -0.888f,
+    0.863f, 4.501f, -0.888f, 0.863f, 4.501f, -0.888f};
+  // Peak motor torque in Nm, bounds policy-predicted torque
+  static constexpr float MAX_TORQUE = 23.7f;
+};
+
+struct AliengoDescription : RobotLayout<4, 3>
+{
+  static constexpr const char * NAME = "aliengo";
+  static constexpr Legs JOINT_ORDER = QUADRUPED_JOINT_ORDER;
+  static constexpr Legs CONTACT_ORDER = QUADRUPED_CONTACT_ORDER;
+  static constexpr Legs CYCLE_ORDER = QUADRUPED_CYCLE_ORDER;
+  static constexpr JointArray NOMINAL{
+    -0.1f, 0.8f, -1.5f, 0.1f, 0.8f, -1.5f,
+    -0.1f, 1.0f, -1.5f, 0.1f, 1.0f, -1.5f};
+  static constexpr JointArray LOWER{
+    -1.222f, -3.142f, -2.775f, -1.222f, -3.142f, -2.775f,
+    -1.222f, -3.142f, -2.775f, -1.222f, -3.142f, -2.775f};
+  static constexpr JointArray UPPER{
+    1.222f, 3.142f, -0.646f, 1.222f, 3.142f, -0.646f,
+    1.222f, 3.142f, -0.646f, 1.222f, 3.142f, -0.646f};
+  // Peak motor torque in Nm, bounds policy-predicted torque
+  static constexpr float MAX_TORQUE = 44.0f;
+};
+
+// Selected by the UNITREE_A1_NEURAL_CONTROL_ROBOT CMake option
+#if defined(UNITREE_A1_NEURAL_CONTROL_ROBOT_GO1)
+using Robot = Go1Description;
+#elif defined(UNITREE_A1_NEURAL_CONTROL_ROBOT_ALIENGO)
+using Robot = AliengoDescription;
+#else
+using Robot = A1Description;
+#endif
+
+// Gather tables of the policy leg order, the robot's defaults unless configured otherwise
+struct LegMapping
+{
+  std::array<uint8_t, Robot::JOINT_COUNT> joints =
+    jointGather<Robot::JOINTS_PER_LEG>(Robot::JOINT_ORDER);
+  std::array<uint8_t, Robot::LEG_COUNT> contacts = legGather(Robot::CONTACT_ORDER);
+  std::array<uint8_t, Robot::LEG_COUNT> cycles = legGather(Robot::CYCLE_ORDER);
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__ROBOT_DESCRIPTION_HPP_
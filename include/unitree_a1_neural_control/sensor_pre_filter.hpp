@@ -0,0 +1,77 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__SENSOR_PRE_FILTER_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__SENSOR_PRE_FILTER_HPP_
+
+#include <array>
+#include <cstdint>
+#include <sensor_msgs/msg/imu.hpp>
+#include <unitree_a1_legged_msgs/msg/low_state.hpp>
+#include "unitree_a1_neural_control/contact_estimator.hpp"
+#include "unitree_a1_neural_control/low_cmd_writer.hpp"
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+using MotorState = decltype(unitree_a1_legged_msgs::msg::LegState::hip);
+using MotorStateTable = std::array<const MotorState *, JOINT_COUNT>;
+
+// Motor states of `leg` in message field order, the counterpart of motorCmdTable
+UNITREE_A1_NEURAL_CONTROL_PUBLIC MotorStateTable motorStateTable(
+  const unitree_a1_legged_msgs::msg::QuadrupedState & leg);
+UNITREE_A1_NEURAL_CONTROL_PUBLIC std::array<MotorState *, JOINT_COUNT> motorStateTable(
+  unitree_a1_legged_msgs::msg::QuadrupedState & leg);
+
+struct SensorFilterConfig
+{
+  // Low-pass weight of a new joint velocity sample, 1 disables filtering
+  float dq_alpha = 1.0f;
+  ContactEstimatorConfig contact = ContactEstimatorConfig::uniform(20.0f);
+  void validate() const;
+};
+
+// Running estimates over every sensor sample. Sums are cumulative, the difference of two
+// snapshots is the exact mean over the samples between them.
+struct SensorSnapshot
+{
+  uint64_t samples = 0;
+  std::array<double, 3> angular_velocity_sum{};
+  // Low-pass filtered joint velocities in message field order
+  JointArray dq{};
+  // Contact flags in message field order
+  FootArray contact{};
+};
+
+// Runs in the state subscription callback at the full sensor rate, a few dozen floating point
+// operations per sample
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC SensorPreFilter
+{
+public:
+  explicit SensorPreFilter(const SensorFilterConfig & config = SensorFilterConfig());
+  void setConfig(const SensorFilterConfig & config);
+  void update(
+    const sensor_msgs::msg::Imu & imu, const unitree_a1_legged_msgs::msg::LowState & state);
+  const SensorSnapshot & snapshot() const;
+  void reset();
+
+private:
+  float dq_alpha_;
+  ContactEstimator contact_;
+  SensorSnapshot snapshot_;
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__SENSOR_PRE_FILTER_HPP_
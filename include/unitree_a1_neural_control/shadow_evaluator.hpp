@@ -0,0 +1,87 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__SHADOW_EVALUATOR_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__SHADOW_EVALUATOR_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "unitree_a1_neural_control/policy_backend.hpp"
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+struct ShadowResult
+{
+  std::vector<float> state;
+  std::vector<float> active_action;
+  std::vector<float> shadow_action;
+  double divergence_l2 = 0.0;
+  double divergence_max = 0.0;
+};
+
+struct ShadowStats
+{
+  uint64_t evaluated = 0;
+  uint64_t dropped = 0;
+  double mean_divergence_l2 = 0.0;
+  double max_divergence = 0.0;
+};
+
+using ShadowCallback = std::function<void (const ShadowResult &)>;
+
+// Runs a candidate policy on the observations of the active one. The control thread only
+// hands over a snapshot with a try-lock, snapshots are dropped while the shadow thread is
+// busy, so the active loop never waits for the candidate.
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC ShadowEvaluator
+{
+public:
+  ShadowEvaluator(
+    const std::string & filepath, size_t observation_size, size_t action_size, int cpu,
+    ShadowCallback callback);
+  ~ShadowEvaluator();
+  ShadowEvaluator(const ShadowEvaluator &) = delete;
+  ShadowEvaluator & operator=(const ShadowEvaluator &) = delete;
+  void post(const std::vector<float> & state, const std::vector<float> & active_action);
+  ShadowStats getStats() const;
+
+private:
+  PolicyBackendPtr backend_;
+  size_t action_size_;
+  std::vector<float> output_;
+  ShadowCallback callback_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool pending_ = false;
+  bool stop_ = false;
+  ShadowResult snapshot_;
+  ShadowResult result_;
+  std::atomic<uint64_t> dropped_{0};
+  mutable std::mutex stats_mutex_;
+  ShadowStats stats_;
+  void run();
+  void evaluate();
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__SHADOW_EVALUATOR_HPP_
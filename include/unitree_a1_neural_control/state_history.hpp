@@ -0,0 +1,81 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__STATE_HISTORY_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__STATE_HISTORY_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sensor_msgs/msg/imu.hpp>
+#include <unitree_a1_legged_msgs/msg/low_state.hpp>
+#include "unitree_a1_neural_control/low_cmd_writer.hpp"
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+// The interpolated part of one synchronized Imu/LowState pair, joints in message field order
+struct StateSample
+{
+  int64_t stamp_ns = 0;
+  JointArray q{};
+  JointArray dq{};
+  JointArray tau_est{};
+  std::array<double, 3> angular_velocity{};
+  std::array<double, 3> linear_acceleration{};
+  // x, y, z, w
+  std::array<double, 4> orientation{0.0, 0.0, 0.0, 1.0};
+};
+
+// Overwrites the interpolated fields of `imu` and `state`, the rest keeps its values
+UNITREE_A1_NEURAL_CONTROL_PUBLIC void applyStateSample(
+  const StateSample & sample, sensor_msgs::msg::Imu & imu,
+  unitree_a1_legged_msgs::msg::LowState & state);
+
+// Fixed-capacity ring of the latest samples indexed by stamp. One writer pushes, one reader
+// interpolates concurrently without locks: every slot is a seqlock over the whole ring, the
+// reader retries when the writer overwrote a slot during the copy. Slots are copied word by
+// word with relaxed atomics, so an overlapping copy is torn but never a data race. Neither
+// side allocates.
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC StateHistory
+{
+public:
+  static constexpr size_t CAPACITY = 64;
+  // Writer side, stamps have to increase, older ones are dropped
+  void push(
+    int64_t stamp_ns, const sensor_msgs::msg::Imu & imu,
+    const unitree_a1_legged_msgs::msg::LowState & state);
+  // Reader side, state at `target_ns` interpolated between the two samples around it. Held at
+  // the newest or oldest sample outside the buffered range, false while empty.
+  bool sample(int64_t target_ns, StateSample & out) const;
+  size_t size() const;
+
+private:
+  static constexpr size_t SLOT_WORDS =
+    (sizeof(StateSample) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+  using Slot = std::array<std::atomic<uint64_t>, SLOT_WORDS>;
+  void storeSlot(size_t slot, const StateSample & sample);
+  void loadSlot(size_t slot, StateSample & sample) const;
+  std::array<Slot, CAPACITY> slots_{};
+  std::array<std::atomic<int64_t>, CAPACITY> stamps_{};
+  // Samples published so far, and the sample the writer is filling in
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> writing_{0};
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__STATE_HISTORY_HPP_
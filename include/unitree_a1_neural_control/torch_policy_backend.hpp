@@ -0,0 +1,46 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__TORCH_POLICY_BACKEND_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__TORCH_POLICY_BACKEND_HPP_
+
+#include <torch/script.h>
+#include <string>
+#include "unitree_a1_neural_control/policy_backend.hpp"
+#include "unitree_a1_neural_control/visibility_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+// Loads a TorchScript policy, freezes and optimizes it for inference
+UNITREE_A1_NEURAL_CONTROL_PUBLIC torch::jit::script::Module loadPolicyModule(
+  const std::string & path);
+
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC TorchPolicyBackend : public PolicyBackend
+{
+public:
+  TorchPolicyBackend(const std::string & filepath, size_t observation_size);
+  void forward(const float * observation, float * action) override;
+  size_t observationSize() const override;
+  size_t actionSize() const override;
+
+private:
+  torch::jit::script::Module module_;
+  size_t observation_size_;
+  size_t action_size_;
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__TORCH_POLICY_BACKEND_HPP_
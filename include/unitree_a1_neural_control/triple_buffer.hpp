@@ -0,0 +1,70 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__TRIPLE_BUFFER_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__TRIPLE_BUFFER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace unitree_a1_neural_control
+{
+
+// Lock-free single producer, single consumer snapshot. The writer fills its private slot and
+// swaps it with the shared one, the reader swaps the shared slot in only when it holds a
+// newer value. Neither side ever waits and the reader always sees a complete value.
+template<typename T>
+class TripleBuffer
+{
+public:
+  explicit TripleBuffer(const T & initial = T())
+  : buffers_{initial, initial, initial} {}
+
+  // Writer side
+  T & writeBuffer()
+  {
+    return buffers_[write_];
+  }
+  void publish()
+  {
+    write_ = shared_.exchange(write_ | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+  }
+  void write(const T & value)
+  {
+    buffers_[write_] = value;
+    this->publish();
+  }
+
+  // Reader side, returns the latest published value
+  const T & read()
+  {
+    if (shared_.load(std::memory_order_relaxed) & FRESH) {
+      read_ = shared_.exchange(read_, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+    return buffers_[read_];
+  }
+
+private:
+  static constexpr uint8_t INDEX_MASK = 0x3;
+  static constexpr uint8_t FRESH = 0x4;
+  std::array<T, 3> buffers_;
+  uint8_t write_ = 0;
+  std::atomic<uint8_t> shared_{1};
+  uint8_t read_ = 2;
+};
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__TRIPLE_BUFFER_HPP_
@@ -16,8 +16,8 @@
 #define UNITREE_A1_NEURAL_CONTROL__UNITREE_A1_NEURAL_CONTROL_HPP_
 
 #include <cstdint>
+#include <memory>
 #include <Eigen/Dense>
-#include <torch/script.h>
 #include <vector>
 #include <string>
 #include <algorithm>
@@ -31,6 +31,15 @@
 #include <unitree_a1_legged_msgs/msg/leg_state.hpp>
 #include <unitree_a1_legged_msgs/msg/foot_force_state.hpp>
 #include <unitree_a1_legged_msgs/msg/debug_double_array.hpp>
+#include "unitree_a1_neural_control/action_chunker.hpp"
+#include "unitree_a1_neural_control/action_post_processor.hpp"
+#include "unitree_a1_neural_control/idle_skipper.hpp"
+#include "unitree_a1_neural_control/low_cmd_writer.hpp"
+#include "unitree_a1_neural_control/policy_bank.hpp"
+#include "unitree_a1_neural_control/policy_ensemble.hpp"
+#include "unitree_a1_neural_control/sensor_pre_filter.hpp"
+#include "unitree_a1_neural_control/shadow_evaluator.hpp"
+#include "unitree_a1_neural_control/triple_buffer.hpp"
 #include "unitree_a1_neural_control/visibility_control.hpp"
 
 using Vector3f = Eigen::Vector3f;
@@ -38,22 +47,46 @@ using Quaternionf = Eigen::Quaternionf;
 
 namespace unitree_a1_neural_control
 {
-constexpr size_t FL = 0;
-constexpr size_t FR = 1;
-constexpr size_t RL = 2 ;
-constexpr size_t RR = 3;
-constexpr size_t FL_cycle = 1;
-constexpr size_t FR_cycle = 0;
-constexpr size_t RL_cycle = 3;
-constexpr size_t RR_cycle = 2;
 constexpr uint8_t PMSM_SERVO_MODE = 0x0A;
+// Observation layout
+constexpr size_t OBS_JOINT_POSITION = Robot::OBS_JOINT_POSITION;
+constexpr size_t OBS_ANGULAR_VELOCITY = Robot::OBS_ANGULAR_VELOCITY;
+constexpr size_t OBS_JOINT_VELOCITY = Robot::OBS_JOINT_VELOCITY;
+constexpr size_t OBS_GOAL_VELOCITY = Robot::OBS_GOAL_VELOCITY;
+constexpr size_t OBS_FOOT_CONTACT = Robot::OBS_FOOT_CONTACT;
+constexpr size_t OBS_GRAVITY = Robot::OBS_GRAVITY;
+constexpr size_t OBS_LAST_ACTION = Robot::OBS_LAST_ACTION;
+constexpr size_t OBS_CYCLES_SINCE_CONTACT = Robot::OBS_CYCLES_SINCE_CONTACT;
+constexpr size_t OBS_SIZE = Robot::OBS_SIZE;
+
+// Tunable without reloading the policy. kp and kd are the common gains, the joint arrays
+// are written to every motor command in action order.
+struct ControlParameters
+{
+  double kp = 50.0;
+  double kd = 4.0;
+  JointArray joint_kp = filledJointArray(50.0f);
+  JointArray joint_kd = filledJointArray(4.0f);
+  JointArray joint_tau = filledJointArray(0.0f);
+  // Observation takes the pre-filtered joint velocities and the angular velocity averaged
+  // over all samples since the last tick, in place of the last sample
+  bool filtered_inputs = false;
+  // Contact estimation of the tick itself, used until the first sensor-rate sample arrives
+  ContactEstimatorConfig contact = ContactEstimatorConfig::uniform(20.0f);
+  static JointArray filledJointArray(float value)
+  {
+    JointArray joints;
+    joints.fill(value);
+    return joints;
+  }
+};
 
 class UNITREE_A1_NEURAL_CONTROL_PUBLIC UnitreeNeuralControl
 {
 public:
   UnitreeNeuralControl(
-    const std::string & filepath, int16_t foot_threshold, std::array<float,
-    12> nominal_joint_position);
+    const std::string & filepath, int16_t foot_threshold,
+    const JointArray & nominal_joint_position);
   unitree_a1_legged_msgs::msg::LowCmd modelForward(
     const geometry_msgs::msg::TwistStamped::SharedPtr goal,
     const unitree_a1_legged_msgs::msg::LowState::SharedPtr msg);
@@ -61,24 +94,98 @@ public:
     const geometry_msgs::msg::TwistStamped::SharedPtr goal,
     const sensor_msgs::msg::Imu::SharedPtr imu,
     const unitree_a1_legged_msgs::msg::LowState::SharedPtr msg);
+  // Safe mode without inference: holds the last commanded position with the configured joint
+  // gains and feed-forward torque, the nominal pose before the first tick. Chunks predicted
+  // before the hold are dropped, the first policy tick after it is rate limited from the
+  // held position.
+  unitree_a1_legged_msgs::msg::LowCmd holdPose();
+  // Pre-filtering at the sensor rate, called for every synchronized sample from one thread,
+  // concurrently with modelForward. modelForward uses the latest estimates, and estimates
+  // foot contact from its own message while no sample has arrived.
+  void updateSensors(
+    const sensor_msgs::msg::Imu & imu, const unitree_a1_legged_msgs::msg::LowState & state);
+  // Setters may be called from one thread at a time, concurrently with modelForward. The
+  // control thread picks the new values up at its next tick without taking a lock.
+  // Uniform threshold, no hysteresis and no filtering
   void setFootContactThreshold(int16_t threshold);
+  void setContactEstimation(const ContactEstimatorConfig & config);
+  // Nominal threshold and per-foot configuration, published together
+  void setContactEstimation(int16_t threshold, const ContactEstimatorConfig & config);
+  void setSensorFiltering(bool filtered_inputs, float dq_alpha);
   int16_t getFootContactThreshold() const;
   void getInputAndOutput(std::vector<float> & input, std::vector<float> & output);
   void resetController();
+  // Uniform gains, overrides the per-joint values
   void setGains(double kp, double kd);
+  void setJointGains(const JointArray & kp, const JointArray & kd, const JointArray & tau);
+  // Uniform and per-joint gains, published together
+  void setGains(
+    double kp, double kd, const JointArray & joint_kp, const JointArray & joint_kd,
+    const JointArray & joint_tau);
+  // Layout of the policy output, the position head alone by default. Resets action
+  // chunking, so call it before setActionChunking and setShadowPolicy.
+  void setOutputHeads(const std::vector<OutputHeadConfig> & heads);
+  // Position target bounds and per-tick step limit, kept across setOutputHeads
+  void setJointLimits(const JointLimits & limits);
+  // Leg order the policy was trained with, call before the control loop starts
+  void setLegMapping(const LegMapping & mapping);
+  void setActionChunking(
+    size_t chunk_size, size_t execution_horizon, bool temporal_ensemble,
+    double ensemble_decay);
+  void setIdleSkipping(
+    bool enabled, double observation_threshold, double goal_threshold,
+    size_t keep_alive_ticks);
+  InferenceStats getInferenceStats() const;
+  void addPolicy(const std::string & name, const std::string & filepath);
+  bool selectPolicy(const std::string & name);
+  std::string getActivePolicy() const;
+  std::vector<std::string> getPolicyNames() const;
+  void setPolicyCrossfade(size_t crossfade_ticks, int cpu);
+  void setShadowPolicy(const std::string & filepath, int cpu, ShadowCallback callback);
+  ShadowStats getShadowStats() const;
+  void setEnsemble(
+    const std::vector<std::string> & filepaths, EnsembleMode mode, size_t batched_size,
+    EnsembleReduction reduction, const std::vector<int> & cpus = {});
+  std::vector<float> getUncertainty() const;
 
 private:
   std::string model_path_;
-  torch::jit::script::Module module_;
+  PolicyBank policy_bank_{OBS_SIZE};
+  std::unique_ptr<ShadowEvaluator> shadow_;
+  std::unique_ptr<PolicyEnsemble> ensemble_;
   double scaled_factor_ = 0.25;
-  double kp_ = 50.0;
-  double kd_ = 4.0;
+  // Written by the setters, published to the control thread through a triple buffer
+  ControlParameters pending_parameters_;
+  TripleBuffer<ControlParameters> shared_parameters_;
+  // Snapshot used by the current tick
+  ControlParameters parameters_;
   int16_t foot_contact_threshold_;
-  std::array<float, 12> nominal_;
-  std::array<float, 4> foot_contact_;
-  std::array<float, 4> cycles_since_last_contact_;
+  // Filter configuration goes to the sensor thread, snapshots come back
+  SensorFilterConfig pending_filter_config_;
+  TripleBuffer<SensorFilterConfig> shared_filter_config_;
+  SensorPreFilter pre_filter_;
+  TripleBuffer<SensorSnapshot> shared_sensors_;
+  // Snapshot of the previous tick, and the angular velocity averaged since then
+  SensorSnapshot sensors_;
+  std::array<float, 3> window_angular_velocity_{};
+  JointArray nominal_;
+  LegMapping leg_mapping_;
+  // Observation blocks, in policy slot order
+  std::array<float, Robot::LEG_COUNT> foot_contact_;
+  std::array<float, Robot::LEG_COUNT> cycles_since_last_contact_;
+  // Per leg in message field order
+  std::array<float, Robot::LEG_COUNT> leg_contact_;
+  // Contact from the message of the tick, for callers that never call updateSensors
+  ContactEstimator tick_contact_;
+  std::array<float, Robot::LEG_COUNT> leg_cycles_;
+  // Raw policy output of the last tick, all heads
   std::vector<float> last_action_;
+  ActionPostProcessor post_processor_;
+  std::vector<OutputHeadConfig> output_heads_;
+  JointLimits joint_limits_ = JointLimits::unlimited();
   std::vector<float> last_state_;
+  ActionChunker chunker_{1, JOINT_COUNT, 1, false, 0.0};
+  IdleSkipper idle_skipper_{false, 0.0, 0.0, 1, OBS_GOAL_VELOCITY};
   std::vector<float> msgToTensor(
     const geometry_msgs::msg::TwistStamped::SharedPtr goal,
     const unitree_a1_legged_msgs::msg::LowState::SharedPtr msg);
@@ -86,18 +193,20 @@ private:
     const geometry_msgs::msg::TwistStamped::SharedPtr goal,
     const sensor_msgs::msg::Imu::SharedPtr imu,
     const unitree_a1_legged_msgs::msg::LowState::SharedPtr msg);
-  unitree_a1_legged_msgs::msg::LowCmd actionToMsg(const std::vector<float> & action);
+  unitree_a1_legged_msgs::msg::LowCmd stateForward(std::vector<float> & state);
+  unitree_a1_legged_msgs::msg::LowCmd actionToMsg(const ActionPostProcessor & processed);
   std::vector<float> convertToGravityVector(
     const geometry_msgs::msg::Quaternion & orientation);
   unitree_a1_legged_msgs::msg::QuadrupedState normalizeState(
     const unitree_a1_legged_msgs::msg::LowState::SharedPtr msg);
-  std::array<float, 12> pushJointPositions(
+  JointArray pushJointPositions(
     const unitree_a1_legged_msgs::msg::QuadrupedState & joint);
   void pushJointVelocities(
     std::vector<float> & tensor,
-    const unitree_a1_legged_msgs::msg::LegState & joint);
+    const unitree_a1_legged_msgs::msg::QuadrupedState & joint);
   void loadModel();
-  void convertFootForceToContact(const unitree_a1_legged_msgs::msg::FootForceState & foot);
+  // Foot contact comes from `msg` until the first updateSensors call
+  void readSensors(const unitree_a1_legged_msgs::msg::LowState & msg);
   void updateCyclesSinceLastContact();
   void initValues();
   void initControlParams(unitree_a1_legged_msgs::msg::LowCmd & cmd_msg);
@@ -15,9 +15,14 @@
 #ifndef UNITREE_A1_NEURAL_CONTROL__UNITREE_A1_NEURAL_CONTROL_NODE_HPP_
 #define UNITREE_A1_NEURAL_CONTROL__UNITREE_A1_NEURAL_CONTROL_NODE_HPP_
 
+#include <chrono>
 #include <memory>
+#include <set>
 #include <rclcpp/rclcpp.hpp>
+#include <rclcpp_lifecycle/lifecycle_node.hpp>
 #include <geometry_msgs/msg/twist_stamped.hpp>
+#include "unitree_a1_neural_control/input_monitor.hpp"
+#include "unitree_a1_neural_control/state_history.hpp"
 #include "unitree_a1_neural_control/unitree_a1_neural_control.hpp"
 #include <std_srvs/srv/trigger.hpp>
 #include <geometry_msgs/msg/wrench_stamped.hpp>
@@ -36,31 +41,174 @@ using Trigger = std_srvs::srv::Trigger;
 using DebugMsg = unitree_a1_legged_msgs::msg::DebugDoubleArray;
 using SyncPolicy = message_filters::sync_policies::ApproximateTime<Imu, LowState>;
 using Synchronizer = message_filters::Synchronizer<SyncPolicy>;
-using SubscriberLowState = message_filters::Subscriber<LowState>;
-using SubscriberImu = message_filters::Subscriber<Imu>;
 
 using namespace std::placeholders;
 
-class UNITREE_A1_NEURAL_CONTROL_PUBLIC UnitreeNeuralControlNode : public rclcpp::Node
+// Publisher type create_publisher returns on NodeT. A lifecycle publisher drops messages while
+// the node is inactive, which only works through its own non-virtual publish.
+template<typename NodeT, typename MsgT>
+struct NodePublisher
+{
+  using SharedPtr = typename rclcpp::Publisher<MsgT>::SharedPtr;
+};
+
+template<typename MsgT>
+struct NodePublisher<rclcpp_lifecycle::LifecycleNode, MsgT>
+{
+  using SharedPtr = typename rclcpp_lifecycle::LifecyclePublisher<MsgT>::SharedPtr;
+};
+
+// Node logic shared by the plain and the lifecycle node, split into the startup phases the
+// two drive differently. Explicitly instantiated for rclcpp::Node and
+// rclcpp_lifecycle::LifecycleNode.
+template<typename NodeT>
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC UnitreeNeuralControlNodeBase : public NodeT
 {
 public:
-  explicit UnitreeNeuralControlNode(const rclcpp::NodeOptions & options);
+  using SubscriberLowState = message_filters::Subscriber<LowState, NodeT>;
+  using SubscriberImu = message_filters::Subscriber<Imu, NodeT>;
+  template<typename MsgT>
+  using PublisherPtr = typename NodePublisher<NodeT, MsgT>::SharedPtr;
+  explicit UnitreeNeuralControlNodeBase(const rclcpp::NodeOptions & options);
+  ~UnitreeNeuralControlNodeBase() override;
+
+protected:
+  // Reads every parameter, declaring it on the first call
+  void readParameters();
+  // Loads, optimizes and warms up all policies
+  void configureController();
+  // Publishers and the input subscribers, nothing that calls into the controller
+  void createEntities();
+  // cmd_vel subscription, synchronizer, services and the parameter callback, which all use
+  // the controller and are therefore created once it is loaded
+  void createCallbacks();
+  // Runs configureController on a separate thread in parallel with createEntities, then
+  // createCallbacks, and logs the startup phase breakdown
+  void configureNode();
+  void startControlLoop();
+  void stopControlLoop();
+  void destroyEntities();
+  std::vector<rclcpp::PublisherBase::SharedPtr> publishers_;
+  // Start of construction, or of activation for the lifecycle node
+  std::chrono::steady_clock::time_point startup_;
+  bool first_command_ = false;
 
 private:
+  struct StartupTimes
+  {
+    double parameters_ms = 0.0;
+    double controller_ms = 0.0;
+    double subscriptions_ms = 0.0;
+    double synchronizer_ms = 0.0;
+    double publishers_ms = 0.0;
+    double services_ms = 0.0;
+  };
+  StartupTimes startup_times_;
+  struct Parameters
+  {
+    std::string model_path;
+    double kp;
+    double kd;
+    std::vector<double> joint_kp;
+    std::vector<double> joint_kd;
+    std::vector<double> joint_tau;
+    int16_t foot_contact_threshold;
+    std::vector<double> contact_thresholds;
+    double contact_hysteresis;
+    double contact_filter_alpha;
+    bool sensor_filter_enabled;
+    double sensor_filter_dq_alpha;
+    double state_history_delay;
+    double state_timeout;
+    double cmd_vel_timeout;
+    std::vector<std::string> output_heads;
+    std::vector<double> output_scale;
+    std::vector<double> output_min;
+    std::vector<double> output_max;
+    std::vector<double> joint_lower;
+    std::vector<double> joint_upper;
+    double joint_max_step;
+    std::vector<std::string> joint_leg_order;
+    std::vector<std::string> contact_leg_order;
+    std::vector<std::string> cycle_leg_order;
+    int64_t chunk_size;
+    int64_t chunk_horizon;
+    bool chunk_ensemble;
+    double chunk_decay;
+    double idle_obs_threshold;
+    double idle_goal_threshold;
+    int64_t idle_keep_alive;
+    std::vector<std::string> policy_names;
+    std::vector<std::string> policy_paths;
+    std::string initial_policy;
+    int64_t crossfade_ticks;
+    int64_t crossfade_cpu;
+    std::string shadow_model_path;
+    int64_t shadow_cpu;
+    std::vector<std::string> ensemble_paths;
+    std::string ensemble_mode;
+    int64_t ensemble_size;
+    std::string ensemble_reduction;
+    std::vector<int64_t> ensemble_cpus;
+    bool model_cache;
+    std::string model_cache_directory;
+  };
+  Parameters params_;
+  // Every parameter declared by readParameters, the ones parametersCallback does not apply
+  // are only read on configure
+  std::set<std::string> parameter_names_;
+  template<typename T>
+  T readParameter(const std::string & name, const T & default_value);
   UnitreeNeuralControlPtr controller_{nullptr};
-  std::array<float, 12> nominal_joint_position_;
+  JointArray nominal_joint_position_;
   TwistStamped::SharedPtr msg_goal_;
   LowState::SharedPtr msg_state_;
   Imu::SharedPtr msg_imu_;
   std::mutex state_mutex_;
+  bool idle_skip_;
+  // Stamp-indexed samples, the tick reads the state interpolated to a fixed delay before now
+  bool interpolate_state_;
+  StateHistory state_history_;
+  LowState::SharedPtr interpolated_state_;
+  Imu::SharedPtr interpolated_imu_;
   // Subscribers and publishers
   rclcpp::Subscription<TwistStamped>::SharedPtr cmd_vel_;
   std::shared_ptr<SubscriberImu> imu_sub_;
   std::shared_ptr<SubscriberLowState> state_sub_;
   std::shared_ptr<Synchronizer> sync_;
   rclcpp::TimerBase::SharedPtr control_loop_;
-  rclcpp::Publisher<LowCmd>::SharedPtr cmd_;
+  // Input health, one row per topic: imu, state, cmd_vel
+  InputMonitor imu_monitor_{true};
+  InputMonitor state_monitor_{true};
+  InputMonitor cmd_vel_monitor_;
+  rclcpp::TimerBase::SharedPtr input_health_timer_;
+  PublisherPtr<DebugMsg> input_health_;
+  void publishInputHealth();
+  // Stale inputs hold the pose without inference, until the first pair arrives as well
+  int64_t state_receive_ns_ = 0;
+  int64_t cmd_vel_receive_ns_ = 0;
+  bool safe_mode_ = true;
+  uint64_t safe_mode_transitions_ = 0;
+  PublisherPtr<DebugMsg> safe_mode_pub_;
+  void updateSafeMode(int64_t now_ns);
+  void publishSafeMode(int64_t now_ns, double state_age, double cmd_vel_age);
+  PublisherPtr<LowCmd> cmd_;
   rclcpp::Service<Trigger>::SharedPtr reset_;
+  std::vector<typename rclcpp::Service<Trigger>::SharedPtr> select_policy_;
+  std::string stand_policy_;
+  std::string walk_policy_;
+  rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr parameter_callback_;
+  rcl_interfaces::msg::SetParametersResult parametersCallback(
+    const std::vector<rclcpp::Parameter> & parameters);
+  void applyGains();
+  void applyContactEstimation();
+  void applySensorFiltering();
+  std::vector<OutputHeadConfig> outputHeads() const;
+  JointLimits jointLimits() const;
+  LegMapping legMapping() const;
+  template<typename MsgT>
+  PublisherPtr<MsgT> createPublisher(
+    const std::string & topic, const rclcpp::QoS & qos);
   void imuStateCallback(Imu::SharedPtr imu, LowState::SharedPtr state);
   void cmdVelCallback(TwistStamped::SharedPtr msg);
   void controlLoop();
@@ -70,15 +218,51 @@ private:
   // Debug
   bool debug_;
   bool publish_debug_;
-  rclcpp::Publisher<DebugMsg>::SharedPtr debug_tensor_;
-  rclcpp::Publisher<DebugMsg>::SharedPtr debug_action_;
-  rclcpp::Publisher<geometry_msgs::msg::WrenchStamped>::SharedPtr debug_wrench_;
-  rclcpp::Publisher<geometry_msgs::msg::WrenchStamped>::SharedPtr debug_foot_contact_rl_;
-  rclcpp::Publisher<geometry_msgs::msg::WrenchStamped>::SharedPtr debug_foot_contact_rr_;
-  rclcpp::Publisher<geometry_msgs::msg::WrenchStamped>::SharedPtr debug_foot_contact_fl_;
-  rclcpp::Publisher<geometry_msgs::msg::WrenchStamped>::SharedPtr debug_foot_contact_fr_;
+  PublisherPtr<DebugMsg> debug_tensor_;
+  PublisherPtr<DebugMsg> debug_action_;
+  PublisherPtr<geometry_msgs::msg::WrenchStamped> debug_wrench_;
+  PublisherPtr<geometry_msgs::msg::WrenchStamped> debug_foot_contact_rl_;
+  PublisherPtr<geometry_msgs::msg::WrenchStamped> debug_foot_contact_rr_;
+  PublisherPtr<geometry_msgs::msg::WrenchStamped> debug_foot_contact_fl_;
+  PublisherPtr<geometry_msgs::msg::WrenchStamped> debug_foot_contact_fr_;
+  // Shadow policy
+  bool shadow_enabled_;
+  PublisherPtr<DebugMsg> shadow_action_;
+  PublisherPtr<DebugMsg> shadow_divergence_;
+  void publishShadowResult(const ShadowResult & result);
+  void logPolicyLoadStats();
+  // Ensemble
+  PublisherPtr<DebugMsg> uncertainty_;
   void publishDebugMsg();
 };
+
+// Loads the policies and starts the control loop in the constructor
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC UnitreeNeuralControlNode
+  : public UnitreeNeuralControlNodeBase<rclcpp::Node>
+{
+public:
+  explicit UnitreeNeuralControlNode(const rclcpp::NodeOptions & options);
+};
+
+// Managed variant: policies are loaded, optimized and warmed up in on_configure, on_activate
+// only enables the publishers and starts the timer, so a configured controller goes live
+// within one tick. Parameters are declared at construction and read again on every configure.
+class UNITREE_A1_NEURAL_CONTROL_PUBLIC UnitreeNeuralControlLifecycleNode
+  : public UnitreeNeuralControlNodeBase<rclcpp_lifecycle::LifecycleNode>
+{
+public:
+  using CallbackReturn =
+    rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn;
+  explicit UnitreeNeuralControlLifecycleNode(const rclcpp::NodeOptions & options);
+  CallbackReturn on_configure(const rclcpp_lifecycle::State & state) override;
+  CallbackReturn on_activate(const rclcpp_lifecycle::State & state) override;
+  CallbackReturn on_deactivate(const rclcpp_lifecycle::State & state) override;
+  CallbackReturn on_cleanup(const rclcpp_lifecycle::State & state) override;
+  CallbackReturn on_shutdown(const rclcpp_lifecycle::State & state) override;
+
+private:
+  void setPublishersActive(bool active);
+};
 }  // namespace unitree_a1_neural_control
 
 #endif  // UNITREE_A1_NEURAL_CONTROL__UNITREE_A1_NEURAL_CONTROL_NODE_HPP_
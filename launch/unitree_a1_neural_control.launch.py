@@ -28,9 +28,12 @@ def launch_setup(context, *args, **kwargs):
             [FindPackageShare('unitree_a1_neural_control'), 'config', 'unitree_a1_neural_control.param.yaml']
         ).perform(context)
 
+    # The lifecycle node loads the policy on configure and starts on activate
+    lifecycle = LaunchConfiguration('use_lifecycle_node').perform(context).lower() == 'true'
     unitree_a1_neural_control_node = Node(
         package='unitree_a1_neural_control',
-        executable='unitree_a1_neural_control_node_exe',
+        executable='unitree_a1_neural_control_lifecycle_node_exe' if lifecycle
+        else 'unitree_a1_neural_control_node_exe',
         name='unitree_a1_neural_control_node',
         parameters=[
             param_path
@@ -59,6 +62,7 @@ def generate_launch_description():
         )
 
     add_launch_arg('unitree_a1_neural_control_param_file', '')
+    add_launch_arg('use_lifecycle_node', 'false')
     add_launch_arg('input_state_name', '/unitree_a1_legged/state')
     add_launch_arg('output_cmd_name', '/unitree_a1_legged/nn/cmd')
     add_launch_arg('input_cmd_vel_name', '/unitree_a1_legged/cmd_vel')
@@ -0,0 +1,273 @@
+#!/usr/bin/env python3
+# Copyright 2023 Maciej Krupka
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Generate a fixed-shape C++ policy kernel from a TorchScript (.pt) or ONNX (.onnx) MLP.
+
+With --format cpp (default) the weights are emitted as alignas(64) constexpr arrays and the
+forward pass as a chain of generated::dense<> calls, see
+include/unitree_a1_neural_control/generated_policy_kernel.hpp. The result is compiled into a
+policy backend plugin that does not need libtorch at runtime.
+
+With --format native the weights are written to a native weight file (.npw) evaluated by
+NativePolicyBackend, see include/unitree_a1_neural_control/native_policy_backend.hpp.
+"""
+
+import argparse
+import os
+import struct
+import tempfile
+
+import numpy as np
+
+NATIVE_MAGIC = b'A1POLICY'
+NATIVE_VERSION = 1
+NATIVE_ALIGNMENT = 64
+NATIVE_ACTIVATIONS = {'identity': 0, 'relu': 1, 'elu': 2, 'tanh': 3}
+
+ACTIVATIONS = {
+    'identity': 'IDENTITY',
+    'relu': 'RELU',
+    'elu': 'ELU',
+    'tanh': 'TANH',
+}
+
+
+class Layer:
+
+    def __init__(self, weight, bias):
+        # weight is [out, in] like torch.nn.Linear
+        self.weight = np.asarray(weight, dtype=np.float32)
+        self.bias = np.asarray(bias, dtype=np.float32)
+        self.activation = 'identity'
+
+
+# TorchScript leaf modules by original_name, activations apply to the Linear before them
+TORCH_ACTIVATIONS = {'ELU': 'elu', 'ReLU': 'relu', 'Tanh': 'tanh'}
+TORCH_PASSTHROUGH = ('Identity', 'Dropout', 'Flatten')
+# Forward graph operators checked against the walked layers, anything listed as unsupported
+# means the forward computes more than the layers
+GRAPH_OPERATORS = {
+    'aten::linear': 'linear',
+    'aten::elu': 'elu', 'aten::elu_': 'elu',
+    'aten::relu': 'relu', 'aten::relu_': 'relu',
+    'aten::tanh': 'tanh', 'aten::tanh_': 'tanh',
+}
+UNSUPPORTED_GRAPH_OPERATORS = (
+    'aten::add', 'aten::add_', 'aten::sub', 'aten::sub_', 'aten::mul', 'aten::mul_',
+    'aten::div', 'aten::div_', 'aten::matmul', 'aten::addmm', 'aten::clamp', 'aten::clamp_',
+    'aten::sigmoid', 'aten::softplus', 'aten::leaky_relu', 'aten::gelu', 'aten::silu',
+    'aten::layer_norm', 'aten::batch_norm', 'aten::cat', 'aten::reshape', 'aten::view',
+)
+
+
+def torchscript_leaves(module, prefix=''):
+    children = list(module.named_children())
+    if not children:
+        yield prefix or '<root>', module
+    for name, child in children:
+        yield from torchscript_leaves(child, prefix + '.' + name if prefix else name)
+
+
+def load_torchscript(path):
+    import torch
+    module = torch.jit.load(path, map_location='cpu')
+    layers = []
+    sequence = []
+    for name, leaf in torchscript_leaves(module):
+        kind = leaf.original_name
+        if kind == 'Linear':
+            weight = leaf.weight.detach().cpu().numpy()
+            bias = leaf.bias.detach().cpu().numpy() if leaf.bias is not None else \
+                np.zeros(weight.shape[0], dtype=np.float32)
+            layers.append(Layer(weight, bias))
+            sequence.append('linear')
+        elif kind in TORCH_ACTIVATIONS:
+            if not layers or sequence[-1] != 'linear':
+                raise RuntimeError('%s (%s) does not follow a Linear layer' % (name, kind))
+            if kind == 'ELU' and abs(float(getattr(leaf, 'alpha', 1.0)) - 1.0) > 1e-6:
+                raise RuntimeError('%s: only ELU with alpha = 1 is supported' % name)
+            layers[-1].activation = TORCH_ACTIVATIONS[kind]
+            sequence.append(layers[-1].activation)
+        elif kind not in TORCH_PASSTHROUGH:
+            raise RuntimeError('Unsupported layer %s (%s)' % (name, kind))
+    # Submodule order is declaration order, the forward has to run them exactly like that
+    graph = [GRAPH_OPERATORS.get(node.kind(), node.kind())
+             for node in module.inlined_graph.nodes()
+             if node.kind() in GRAPH_OPERATORS or node.kind() in UNSUPPORTED_GRAPH_OPERATORS]
+    if graph != sequence:
+        raise RuntimeError('Forward of %s does not match its layers\n  forward: %s\n  layers:  %s'
+                           % (path, ' -> '.join(graph), ' -> '.join(sequence)))
+    return layers
+
+
+def load_onnx(path):
+    import onnx
+    from onnx import numpy_helper
+    model = onnx.load(path)
+    initializers = {i.name: numpy_helper.to_array(i) for i in model.graph.initializer}
+    layers = []
+    for node in model.graph.node:
+        attributes = {a.name: onnx.helper.get_attribute_value(a) for a in node.attribute}
+        if node.op_type == 'Gemm':
+            weight = initializers[node.input[1]]
+            if not attributes.get('transB', 0):
+                weight = weight.T
+            bias = initializers[node.input[2]] if len(node.input) > 2 else \
+                np.zeros(weight.shape[0], dtype=np.float32)
+            layers.append(Layer(weight, bias))
+        elif node.op_type == 'MatMul':
+            layers.append(Layer(initializers[node.input[1]].T,
+                                np.zeros(initializers[node.input[1]].shape[1], np.float32)))
+        elif node.op_type == 'Add' and layers and node.input[1] in initializers:
+            layers[-1].bias = layers[-1].bias + initializers[node.input[1]]
+        elif node.op_type in ('Relu', 'Tanh'):
+            layers[-1].activation = node.op_type.lower()
+        elif node.op_type == 'Elu':
+            if abs(attributes.get('alpha', 1.0) - 1.0) > 1e-6:
+                raise RuntimeError('Only ELU with alpha = 1 is supported')
+            layers[-1].activation = 'elu'
+        elif node.op_type not in ('Identity', 'Flatten'):
+            raise RuntimeError('Unsupported ONNX operator: ' + node.op_type)
+    return layers
+
+
+def format_array(values):
+    flat = ['%.9ef' % v for v in np.asarray(values, dtype=np.float32).reshape(-1)]
+    lines = [', '.join(flat[i:i + 6]) for i in range(0, len(flat), 6)]
+    return ',\n    '.join(lines)
+
+
+def generate(layers, source):
+    for previous, layer in zip(layers, layers[1:]):
+        if previous.weight.shape[0] != layer.weight.shape[1]:
+            raise RuntimeError('Layer sizes do not chain')
+    observation_size = layers[0].weight.shape[1]
+    action_size = layers[-1].weight.shape[0]
+    out = []
+    out.append('// Generated by scripts/generate_policy_kernel.py from %s. Do not edit.'
+               % os.path.basename(source))
+    out.append('#include <string>')
+    out.append('#include "unitree_a1_neural_control/generated_policy_kernel.hpp"')
+    out.append('')
+    out.append('namespace')
+    out.append('{')
+    out.append('using unitree_a1_neural_control::generated::Activation;')
+    out.append('using unitree_a1_neural_control::generated::dense;')
+    out.append('')
+    for i, layer in enumerate(layers):
+        n_out, n_in = layer.weight.shape
+        out.append('alignas(64) constexpr float LAYER%d_WEIGHT[%d][%d] = {' % (i, n_in, n_out))
+        for row in layer.weight.T:
+            out.append('  {\n    %s},' % format_array(row))
+        out.append('};')
+        out.append('alignas(64) constexpr float LAYER%d_BIAS[%d] = {\n    %s};'
+                   % (i, n_out, format_array(layer.bias)))
+        out.append('')
+    out.append('class GeneratedPolicyBackend : public unitree_a1_neural_control::PolicyBackend')
+    out.append('{')
+    out.append('public:')
+    out.append('  GeneratedPolicyBackend(const std::string & /*filepath*/, '
+               'size_t /*observation_size*/) {}')
+    out.append('  void forward(const float * observation, float * action) override')
+    out.append('  {')
+    for i, layer in enumerate(layers):
+        src = 'observation' if i == 0 else 'buffer%d_' % (i - 1)
+        dst = 'action' if i == len(layers) - 1 else 'buffer%d_' % i
+        out.append('    dense<Activation::%s>(LAYER%d_WEIGHT, LAYER%d_BIAS, %s, %s);'
+                   % (ACTIVATIONS[layer.activation], i, i, src, dst))
+    out.append('  }')
+    out.append('  size_t observationSize() const override {return %d;}' % observation_size)
+    out.append('  size_t actionSize() const override {return %d;}' % action_size)
+    out.append('')
+    out.append('private:')
+    for i, layer in enumerate(layers[:-1]):
+        out.append('  alignas(64) float buffer%d_[%d];' % (i, layer.weight.shape[0]))
+    out.append('};')
+    out.append('}  // namespace')
+    out.append('')
+    out.append('UNITREE_A1_NEURAL_CONTROL_EXPORT_POLICY_BACKEND(GeneratedPolicyBackend)')
+    out.append('')
+    return '\n'.join(out)
+
+
+def write_native(layers, path):
+    for previous, layer in zip(layers, layers[1:]):
+        if previous.weight.shape[0] != layer.weight.shape[1]:
+            raise RuntimeError('Layer sizes do not chain')
+
+    def align(offset):
+        return (offset + NATIVE_ALIGNMENT - 1) // NATIVE_ALIGNMENT * NATIVE_ALIGNMENT
+
+    # Header is 64 bytes, every layer entry 32 bytes
+    offset = align(64 + 32 * len(layers))
+    table = []
+    blobs = []
+    for layer in layers:
+        weight = np.ascontiguousarray(layer.weight, dtype='<f4').tobytes()
+        bias = np.ascontiguousarray(layer.bias, dtype='<f4').tobytes()
+        weight_offset = offset
+        bias_offset = align(weight_offset + len(weight))
+        offset = align(bias_offset + len(bias))
+        table.append(struct.pack('<IIIIQQ', layer.weight.shape[0], layer.weight.shape[1],
+                                 NATIVE_ACTIVATIONS[layer.activation], 0,
+                                 weight_offset, bias_offset))
+        blobs.append((weight_offset, weight))
+        blobs.append((bias_offset, bias))
+    data = bytearray(offset)
+    header = struct.pack('<8sIIII', NATIVE_MAGIC, NATIVE_VERSION, len(layers),
+                         layers[0].weight.shape[1], layers[-1].weight.shape[0])
+    data[0:len(header)] = header
+    for i, entry in enumerate(table):
+        data[64 + 32 * i:64 + 32 * (i + 1)] = entry
+    for blob_offset, blob in blobs:
+        data[blob_offset:blob_offset + len(blob)] = blob
+    # Running controllers map the weights shared, rewriting the file in place would truncate
+    # their mapping. Write a sibling file and rename it over the target instead.
+    directory = os.path.dirname(os.path.abspath(path))
+    fd, temporary = tempfile.mkstemp(dir=directory, prefix='.' + os.path.basename(path) + '.')
+    try:
+        with os.fdopen(fd, 'wb') as f:
+            f.write(bytes(data))
+        os.chmod(temporary, 0o644)
+        os.replace(temporary, path)
+    except BaseException:
+        os.unlink(temporary)
+        raise
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--input', required=True, help='TorchScript (.pt) or ONNX (.onnx) policy')
+    parser.add_argument('--output', required=True,
+                        help='generated C++ source or native weight file')
+    parser.add_argument('--format', choices=('cpp', 'native'), default='cpp',
+                        help='C++ kernel source or native weight file (.npw)')
+    args = parser.parse_args()
+    if args.input.endswith('.onnx'):
+        layers = load_onnx(args.input)
+    else:
+        layers = load_torchscript(args.input)
+    if not layers:
+        raise RuntimeError('No layers found in ' + args.input)
+    if args.format == 'native':
+        write_native(layers, args.output)
+        return
+    source = generate(layers, args.input)
+    with open(args.output, 'w') as f:
+        f.write(source)
+
+
+if __name__ == '__main__':
+    main()
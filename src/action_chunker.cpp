@@ -0,0 +1,125 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/action_chunker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace unitree_a1_neural_control
+{
+
+ActionChunker::ActionChunker(
+  size_t chunk_size, size_t action_size, size_t execution_horizon,
+  bool temporal_ensemble, double ensemble_decay)
+{
+  chunk_size_ = std::max<size_t>(chunk_size, 1);
+  action_size_ = action_size;
+  execution_horizon_ = (execution_horizon == 0) ?
+    chunk_size_ : std::min(execution_horizon, chunk_size_);
+  temporal_ensemble_ = temporal_ensemble;
+  ensemble_decay_ = ensemble_decay;
+  // Only chunks that still overlap the current tick are kept
+  max_chunks_ = temporal_ensemble_ ?
+    (chunk_size_ + execution_horizon_ - 1) / execution_horizon_ : 1;
+  chunks_.resize(max_chunks_ * chunk_size_ * action_size_);
+  start_ticks_.resize(max_chunks_);
+  accumulator_.resize(action_size_);
+}
+
+bool ActionChunker::needsInference() const
+{
+  return count_ == 0 || (tick_ - last_push_tick_) >= execution_horizon_;
+}
+
+void ActionChunker::pushChunk(const float * chunk, size_t size)
+{
+  if (size != chunk_size_ * action_size_) {
+    throw std::invalid_argument(
+            "Policy output has " + std::to_string(size) + " values, expected [" +
+            std::to_string(chunk_size_) + ", " + std::to_string(action_size_) + "]");
+  }
+  size_t slot;
+  if (count_ == max_chunks_) {
+    // Overwrite the oldest chunk
+    slot = head_;
+    head_ = (head_ + 1) % max_chunks_;
+  } else {
+    slot = (head_ + count_) % max_chunks_;
+    count_++;
+  }
+  std::copy(chunk, chunk + size, chunks_.begin() + slot * chunk_size_ * action_size_);
+  start_ticks_[slot] = tick_;
+  last_push_tick_ = tick_;
+}
+
+void ActionChunker::nextAction(std::vector<float> & action)
+{
+  action.resize(action_size_);
+  // Drop chunks that no longer cover the current tick
+  while (count_ > 0 && tick_ >= start_ticks_[head_] + chunk_size_) {
+    head_ = (head_ + 1) % max_chunks_;
+    count_--;
+  }
+  if (count_ == 0) {
+    tick_++;
+    return;
+  }
+  auto step = [&](size_t slot) {
+      const size_t offset = static_cast<size_t>(tick_ - start_ticks_[slot]);
+      return chunks_.begin() + (slot * chunk_size_ + offset) * action_size_;
+    };
+  if (!temporal_ensemble_) {
+    auto newest = step((head_ + count_ - 1) % max_chunks_);
+    std::copy(newest, newest + action_size_, action.begin());
+    tick_++;
+    return;
+  }
+  std::fill(accumulator_.begin(), accumulator_.end(), 0.0);
+  double weight_sum = 0.0;
+  for (size_t i = 0; i < count_; i++) {
+    const double weight = std::exp(-ensemble_decay_ * static_cast<double>(i));
+    auto prediction = step((head_ + i) % max_chunks_);
+    for (size_t j = 0; j < action_size_; j++) {
+      accumulator_[j] += weight * prediction[j];
+    }
+    weight_sum += weight;
+  }
+  for (size_t j = 0; j < action_size_; j++) {
+    action[j] = static_cast<float>(accumulator_[j] / weight_sum);
+  }
+  tick_++;
+}
+
+void ActionChunker::reset()
+{
+  head_ = 0;
+  count_ = 0;
+  tick_ = 0;
+  last_push_tick_ = 0;
+}
+
+size_t ActionChunker::chunkSize() const
+{
+  return chunk_size_;
+}
+
+size_t ActionChunker::actionSize() const
+{
+  return action_size_;
+}
+
+}  // namespace unitree_a1_neural_control
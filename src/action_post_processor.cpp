@@ -0,0 +1,141 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/action_post_processor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace unitree_a1_neural_control
+{
+
+ActionPostProcessor::ActionPostProcessor()
+: ActionPostProcessor({{OutputHead::POSITION, 1.0f}}, {}) {}
+
+ActionPostProcessor::ActionPostProcessor(
+  const std::vector<OutputHeadConfig> & heads, const JointArray & nominal,
+  const JointLimits & limits)
+{
+  head_index_.fill(-1);
+  const auto size = static_cast<Eigen::Index>(heads.size() * JOINT_COUNT);
+  scale_.resize(size);
+  offset_.setZero(size);
+  lower_.resize(size);
+  upper_.resize(size);
+  step_.setConstant(size, std::numeric_limits<float>::infinity());
+  for (size_t i = 0; i < heads.size(); i++) {
+    const auto & head = heads[i];
+    auto & index = head_index_[static_cast<size_t>(head.head)];
+    if (index >= 0) {
+      throw std::invalid_argument("Output head configured twice");
+    }
+    if (!(head.min <= head.max)) {
+      throw std::invalid_argument("Output head clamp range is empty");
+    }
+    index = static_cast<int>(i);
+    const auto block = static_cast<Eigen::Index>(i * JOINT_COUNT);
+    const auto joints = static_cast<Eigen::Index>(JOINT_COUNT);
+    scale_.segment(block, joints).setConstant(head.scale);
+    lower_.segment(block, joints).setConstant(head.min);
+    upper_.segment(block, joints).setConstant(head.max);
+    if (head.head == OutputHead::POSITION) {
+      if (limits.max_step < 0.0f) {
+        throw std::invalid_argument("Joint step limit has to be non-negative");
+      }
+      offset_.segment(block, joints) = Eigen::Map<const Eigen::ArrayXf>(nominal.data(), joints);
+      // Joint limits narrow the head range
+      lower_.segment(block, joints) = lower_.segment(block, joints).max(
+        Eigen::Map<const Eigen::ArrayXf>(limits.lower.data(), joints));
+      upper_.segment(block, joints) = upper_.segment(block, joints).min(
+        Eigen::Map<const Eigen::ArrayXf>(limits.upper.data(), joints));
+      if ((lower_.segment(block, joints) > upper_.segment(block, joints)).any()) {
+        throw std::invalid_argument("Joint limits do not overlap the position head range");
+      }
+      if (limits.max_step > 0.0f) {
+        step_.segment(block, joints).setConstant(limits.max_step);
+      }
+    } else {
+      // Gains never go negative, nothing a policy predicts exceeds what the motors take
+      const float bound = head.head == OutputHead::KP ? MAX_HEAD_KP :
+        head.head == OutputHead::KD ? MAX_HEAD_KD : Robot::MAX_TORQUE;
+      const float lowest = head.head == OutputHead::TAU ? -Robot::MAX_TORQUE : 0.0f;
+      lower_.segment(block, joints) = lower_.segment(block, joints).max(lowest);
+      upper_.segment(block, joints) = upper_.segment(block, joints).min(bound);
+      if (!(std::max(head.min, lowest) <= std::min(head.max, bound))) {
+        throw std::invalid_argument("Output head clamp range is outside the safe range");
+      }
+    }
+  }
+  if (head_index_[static_cast<size_t>(OutputHead::POSITION)] < 0) {
+    throw std::invalid_argument("Output heads have to include positions");
+  }
+  output_.resize(size);
+  previous_.resize(size);
+  reset();
+}
+
+void ActionPostProcessor::reset()
+{
+  // Held output until the first tick, the nominal pose and zero gains. The first policy
+  // output is rate limited from it and non-finite values fall back to it.
+  previous_ = offset_.max(lower_).min(upper_);
+  output_ = previous_;
+}
+
+void ActionPostProcessor::process(const float * raw)
+{
+  // Plain branch-free loop over raw pointers, compiles to packed mul, min, max, compare and
+  // blend instructions. Eigen 3.4 evaluates select() one scalar at a time.
+  const size_t size = static_cast<size_t>(output_.size());
+  const float * scale = scale_.data();
+  const float * offset = offset_.data();
+  const float * lower = lower_.data();
+  const float * upper = upper_.data();
+  const float * step = step_.data();
+  const float * previous = previous_.data();
+  float * output = output_.data();
+  for (size_t i = 0; i < size; i++) {
+    float value = raw[i] * scale[i] + offset[i];
+    value = value < lower[i] ? lower[i] : value;
+    value = value > upper[i] ? upper[i] : value;
+    // Position limits hold the previous target, stepping towards it stays inside them
+    const float min_step = previous[i] - step[i];
+    const float max_step = previous[i] + step[i];
+    value = value < min_step ? min_step : value;
+    value = value > max_step ? max_step : value;
+    // NaN and infinity fail the comparison and hold the previous output
+    output[i] = std::fabs(raw[i]) <= std::numeric_limits<float>::max() ? value : previous[i];
+  }
+  previous_ = output_;
+}
+
+const float * ActionPostProcessor::output(OutputHead head) const
+{
+  const int index = head_index_[static_cast<size_t>(head)];
+  return index < 0 ? nullptr : output_.data() + static_cast<size_t>(index) * JOINT_COUNT;
+}
+
+size_t ActionPostProcessor::offset(OutputHead head) const
+{
+  return static_cast<size_t>(head_index_[static_cast<size_t>(head)]) * JOINT_COUNT;
+}
+
+size_t ActionPostProcessor::actionSize() const
+{
+  return static_cast<size_t>(output_.size());
+}
+
+}  // namespace unitree_a1_neural_control
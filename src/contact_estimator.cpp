@@ -0,0 +1,77 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/contact_estimator.hpp"
+
+#include <stdexcept>
+
+namespace unitree_a1_neural_control
+{
+
+void ContactEstimatorConfig::validate() const
+{
+  if (!(alpha > 0.0f && alpha <= 1.0f)) {
+    throw std::invalid_argument("Contact filter weight has to be in (0, 1]");
+  }
+  for (size_t foot = 0; foot < Robot::LEG_COUNT; foot++) {
+    if (!(off_threshold[foot] <= on_threshold[foot])) {
+      throw std::invalid_argument("Contact off threshold has to be at most the on threshold");
+    }
+  }
+}
+
+ContactEstimator::ContactEstimator(const ContactEstimatorConfig & config)
+{
+  this->setConfig(config);
+}
+
+void ContactEstimator::setConfig(const ContactEstimatorConfig & config)
+{
+  config.validate();
+  config_ = config;
+}
+
+void ContactEstimator::update(const FootArray & force)
+{
+  // Fixed trip count and selects only, compiles to one packed operation per step. The local
+  // copy tells the compiler the sample does not alias the state.
+  const FootArray sample = force;
+  const float alpha = config_.alpha;
+  for (size_t foot = 0; foot < Robot::LEG_COUNT; foot++) {
+    const float filtered = filtered_[foot] + alpha * (sample[foot] - filtered_[foot]);
+    const float on = filtered >= config_.on_threshold[foot] ? 1.0f : 0.0f;
+    const float stay = filtered >= config_.off_threshold[foot] ? 1.0f : 0.0f;
+    const float held = contact_[foot] * stay;
+    filtered_[foot] = filtered;
+    contact_[foot] = on > held ? on : held;
+  }
+}
+
+const FootArray & ContactEstimator::contact() const
+{
+  return contact_;
+}
+
+const FootArray & ContactEstimator::filtered() const
+{
+  return filtered_;
+}
+
+void ContactEstimator::reset()
+{
+  filtered_.fill(0.0f);
+  contact_.fill(0.0f);
+}
+
+}  // namespace unitree_a1_neural_control
@@ -0,0 +1,82 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/idle_skipper.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace unitree_a1_neural_control
+{
+
+IdleSkipper::IdleSkipper(
+  bool enabled, double observation_threshold, double goal_threshold,
+  size_t keep_alive_ticks, size_t goal_index)
+{
+  enabled_ = enabled;
+  observation_threshold_ = observation_threshold;
+  goal_threshold_ = goal_threshold;
+  keep_alive_ticks_ = std::max<size_t>(keep_alive_ticks, 1);
+  goal_index_ = goal_index;
+}
+
+bool IdleSkipper::shouldSkip(const std::vector<float> & state)
+{
+  if (!enabled_ || !has_reference_ || ticks_since_inference_ + 1 >= keep_alive_ticks_ ||
+    state.size() != reference_state_.size() || goal_index_ + 3 > state.size())
+  {
+    return false;
+  }
+  // Goal velocity (vx, vy, wz) has to be zero
+  for (size_t i = goal_index_; i < goal_index_ + 3; i++) {
+    if (std::abs(state[i]) > goal_threshold_) {
+      return false;
+    }
+  }
+  // Observation has to stay close to the one used for the last forward
+  for (size_t i = 0; i < state.size(); i++) {
+    if (!(std::abs(state[i] - reference_state_[i]) <= observation_threshold_)) {
+      return false;
+    }
+  }
+  ticks_since_inference_++;
+  stats_.skipped++;
+  stats_.saved_ms = static_cast<double>(stats_.skipped) * stats_.mean_forward_ms;
+  return true;
+}
+
+void IdleSkipper::recordInference(const std::vector<float> & state, double forward_ms)
+{
+  reference_state_.assign(state.begin(), state.end());
+  has_reference_ = true;
+  ticks_since_inference_ = 0;
+  stats_.forwards++;
+  // Running mean of the forward duration
+  stats_.mean_forward_ms +=
+    (forward_ms - stats_.mean_forward_ms) / static_cast<double>(stats_.forwards);
+  stats_.saved_ms = static_cast<double>(stats_.skipped) * stats_.mean_forward_ms;
+}
+
+InferenceStats IdleSkipper::getStats() const
+{
+  return stats_;
+}
+
+void IdleSkipper::reset()
+{
+  has_reference_ = false;
+  ticks_since_inference_ = 0;
+}
+
+}  // namespace unitree_a1_neural_control
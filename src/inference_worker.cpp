@@ -0,0 +1,100 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/inference_worker.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace unitree_a1_neural_control
+{
+
+void configureWorkerThread(std::thread & thread, int cpu, bool low_priority)
+{
+  if (cpu >= 0) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuset);
+  }
+  if (low_priority) {
+    sched_param param{};
+    param.sched_priority = 0;
+    pthread_setschedparam(thread.native_handle(), SCHED_IDLE, &param);
+  }
+}
+
+InferenceWorker::InferenceWorker(int cpu)
+{
+  thread_ = std::thread(&InferenceWorker::run, this);
+  configureWorkerThread(thread_, cpu, false);
+}
+
+InferenceWorker::~InferenceWorker()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+void InferenceWorker::submit(std::function<void()> job)
+{
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] {return !busy_;});
+    job_ = std::move(job);
+    error_ = nullptr;
+    busy_ = true;
+  }
+  cv_.notify_all();
+}
+
+void InferenceWorker::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] {return !busy_;});
+  if (error_) {
+    auto error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void InferenceWorker::run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] {return busy_ || stop_;});
+    if (stop_) {
+      return;
+    }
+    auto job = std::move(job_);
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+      job();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    error_ = error;
+    busy_ = false;
+    cv_.notify_all();
+  }
+}
+
+}  // namespace unitree_a1_neural_control
@@ -0,0 +1,112 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/input_monitor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace unitree_a1_neural_control
+{
+
+namespace
+{
+double toMs(int64_t ns)
+{
+  return static_cast<double>(ns) * 1e-6;
+}
+}  // namespace
+
+double receiveAgeMs(int64_t now_ns, int64_t receive_ns)
+{
+  return receive_ns != 0 ? toMs(now_ns - receive_ns) : std::numeric_limits<double>::infinity();
+}
+
+bool inputsStale(
+  double state_age_ms, double cmd_vel_age_ms, double state_timeout, double cmd_vel_timeout)
+{
+  return (state_timeout > 0.0 && state_age_ms > state_timeout * 1e3) ||
+         (cmd_vel_timeout > 0.0 && cmd_vel_age_ms > cmd_vel_timeout * 1e3);
+}
+
+InputMonitor::InputMonitor(bool synchronized)
+: synchronized_(synchronized) {}
+
+void InputMonitor::reset(int64_t now_ns)
+{
+  *this = InputMonitor(synchronized_);
+  window_start_ns_ = now_ns;
+}
+
+void InputMonitor::received(int64_t receive_ns, int64_t stamp_ns)
+{
+  if (last_receive_ns_ != 0) {
+    const double interval = toMs(receive_ns - last_receive_ns_);
+    interval_count_++;
+    interval_sum_ms_ += interval;
+    interval_sq_sum_ms_ += interval * interval;
+    max_gap_ms_ = std::max(max_gap_ms_, interval);
+  } else {
+    max_gap_ms_ = std::max(max_gap_ms_, toMs(receive_ns - window_start_ns_));
+  }
+  last_receive_ns_ = receive_ns;
+  if (stamp_ns != 0) {
+    const double delay = toMs(receive_ns - stamp_ns);
+    delay_count_++;
+    delay_sum_ms_ += delay;
+    max_delay_ms_ = delay_count_ == 1 ? delay : std::max(max_delay_ms_, delay);
+  }
+  window_count_++;
+  received_total_++;
+}
+
+void InputMonitor::synchronized()
+{
+  synchronized_total_++;
+}
+
+InputHealth InputMonitor::report(int64_t now_ns)
+{
+  InputHealth health;
+  const double window_ms = toMs(now_ns - window_start_ns_);
+  health.received = window_count_;
+  health.rate_hz = window_ms > 0.0 ? 1e3 * static_cast<double>(window_count_) / window_ms : 0.0;
+  if (interval_count_ > 0) {
+    const double count = static_cast<double>(interval_count_);
+    const double mean = interval_sum_ms_ / count;
+    health.jitter_ms = std::sqrt(std::max(interval_sq_sum_ms_ / count - mean * mean, 0.0));
+  }
+  const int64_t open_since = last_receive_ns_ != 0 ? last_receive_ns_ : window_start_ns_;
+  health.max_gap_ms = std::max(max_gap_ms_, toMs(now_ns - open_since));
+  if (delay_count_ > 0) {
+    health.mean_delay_ms = delay_sum_ms_ / static_cast<double>(delay_count_);
+    health.max_delay_ms = max_delay_ms_;
+  }
+  health.dropped = synchronized_ && received_total_ > synchronized_total_ ?
+    received_total_ - synchronized_total_ : 0;
+  // Next window, gaps keep measuring from the last message
+  window_start_ns_ = now_ns;
+  window_count_ = 0;
+  interval_count_ = 0;
+  interval_sum_ms_ = 0.0;
+  interval_sq_sum_ms_ = 0.0;
+  max_gap_ms_ = 0.0;
+  delay_count_ = 0;
+  delay_sum_ms_ = 0.0;
+  max_delay_ms_ = 0.0;
+  return health;
+}
+
+}  // namespace unitree_a1_neural_control
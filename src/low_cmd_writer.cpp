@@ -0,0 +1,46 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/low_cmd_writer.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+MotorCmdTable motorCmdTable(unitree_a1_legged_msgs::msg::LowCmd & cmd)
+{
+  auto & motor = cmd.motor_cmd;
+  return {
+    &motor.front_right.hip, &motor.front_right.thigh, &motor.front_right.calf,
+    &motor.front_left.hip, &motor.front_left.thigh, &motor.front_left.calf,
+    &motor.rear_right.hip, &motor.rear_right.thigh, &motor.rear_right.calf,
+    &motor.rear_left.hip, &motor.rear_left.thigh, &motor.rear_left.calf};
+}
+
+void writeMotorCmds(
+  unitree_a1_legged_msgs::msg::LowCmd & cmd, uint8_t mode, const JointGather & joints,
+  const float * q, const float * kp, const float * kd, const float * tau)
+{
+  const auto table = motorCmdTable(cmd);
+  for (size_t i = 0; i < JOINT_COUNT; i++) {
+    auto & motor = *table[joints[i]];
+    motor.mode = mode;
+    motor.q = q[i];
+    motor.dq = 0.0;
+    motor.kp = kp[i];
+    motor.kd = kd[i];
+    motor.tau = tau[i];
+  }
+}
+
+}  // namespace unitree_a1_neural_control
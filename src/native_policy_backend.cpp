@@ -0,0 +1,143 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/native_policy_backend.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace unitree_a1_neural_control
+{
+
+NativePolicyBackend::NativePolicyBackend(const std::string & filepath, size_t observation_size)
+{
+  // Weights are used in place from a read-only shared mapping, processes running the same
+  // policy share the page cache copy. Pages are populated now, not on the first control tick.
+  int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open native weights '" + filepath + "'");
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    throw std::runtime_error("Cannot read native weights '" + filepath + "'");
+  }
+  const auto size = static_cast<size_t>(st.st_size);
+  void * mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("Cannot map native weights '" + filepath + "'");
+  }
+  storage_ = std::shared_ptr<void>(mapping, [size](void * ptr) {::munmap(ptr, size);});
+  const auto * data = static_cast<const uint8_t *>(storage_.get());
+
+  NativeWeightsHeader header;
+  if (size < sizeof(header)) {
+    throw std::runtime_error("'" + filepath + "' is too small for native weights");
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, NATIVE_WEIGHTS_MAGIC, sizeof(header.magic)) != 0 ||
+    header.version != NATIVE_WEIGHTS_VERSION)
+  {
+    throw std::runtime_error("'" + filepath + "' is not a native weight file");
+  }
+  if (header.observation_size != observation_size) {
+    throw std::runtime_error(
+            "'" + filepath + "' takes " + std::to_string(header.observation_size) +
+            " observation values, the controller builds " + std::to_string(observation_size));
+  }
+  observation_size_ = header.observation_size;
+  action_size_ = header.action_size;
+  size_t in_features = observation_size_;
+  for (uint32_t i = 0; i < header.layer_count; i++) {
+    NativeLayerHeader layer;
+    const size_t offset = sizeof(header) + i * sizeof(layer);
+    if (offset + sizeof(layer) > size) {
+      throw std::runtime_error("'" + filepath + "' is truncated");
+    }
+    std::memcpy(&layer, data + offset, sizeof(layer));
+    // Header fields are untrusted, compared without sums or products that could wrap
+    auto fits = [size](uint64_t tensor_offset, uint64_t count) {
+        return tensor_offset <= size && count <= (size - tensor_offset) / sizeof(float);
+      };
+    const uint64_t weight_count = static_cast<uint64_t>(layer.out_features) * layer.in_features;
+    if (layer.in_features != in_features ||
+      layer.activation >= NATIVE_ACTIVATION_COUNT ||
+      layer.weight_offset % NATIVE_WEIGHTS_ALIGNMENT != 0 ||
+      layer.bias_offset % NATIVE_WEIGHTS_ALIGNMENT != 0 ||
+      !fits(layer.weight_offset, weight_count) ||
+      !fits(layer.bias_offset, layer.out_features))
+    {
+      throw std::runtime_error("'" + filepath + "' has an invalid layer table");
+    }
+    layers_.push_back(
+      {
+        {reinterpret_cast<const float *>(data + layer.weight_offset),
+          layer.out_features, layer.in_features},
+        {reinterpret_cast<const float *>(data + layer.bias_offset), layer.out_features},
+        layer.activation});
+    buffers_.emplace_back(layer.out_features);
+    in_features = layer.out_features;
+  }
+  if (layers_.empty() || in_features != action_size_) {
+    throw std::runtime_error("'" + filepath + "' does not produce the declared action size");
+  }
+}
+
+void NativePolicyBackend::forward(const float * observation, float * action)
+{
+  Eigen::Map<const Eigen::VectorXf> input(observation, observation_size_);
+  for (size_t i = 0; i < layers_.size(); i++) {
+    const auto & layer = layers_[i];
+    auto & output = buffers_[i];
+    if (i == 0) {
+      output.noalias() = layer.weight * input;
+    } else {
+      output.noalias() = layer.weight * buffers_[i - 1];
+    }
+    output += layer.bias;
+    switch (layer.activation) {
+      case 1:
+        output = output.cwiseMax(0.0f);
+        break;
+      case 2:
+        output = (output.array() > 0.0f).select(output.array(), output.array().exp() - 1.0f);
+        break;
+      case 3:
+        output = output.array().tanh();
+        break;
+      default:
+        break;
+    }
+  }
+  Eigen::Map<Eigen::VectorXf>(action, action_size_) = buffers_.back();
+}
+
+size_t NativePolicyBackend::observationSize() const
+{
+  return observation_size_;
+}
+
+size_t NativePolicyBackend::actionSize() const
+{
+  return action_size_;
+}
+
+}  // namespace unitree_a1_neural_control
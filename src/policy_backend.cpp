@@ -0,0 +1,129 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/policy_backend.hpp"
+
+#include <dlfcn.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "unitree_a1_neural_control/native_policy_backend.hpp"
+#include "unitree_a1_neural_control/policy_cache.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+namespace
+{
+
+bool endsWith(const std::string & value, const std::string & suffix)
+{
+  return value.size() >= suffix.size() &&
+         value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Backend plugins are resolved through the library search path
+constexpr char TORCH_BACKEND_PLUGIN[] = "libunitree_a1_neural_control_torch_backend.so";
+
+// Backend living in a shared library, the library stays mapped as long as the backend exists.
+// `library` is either a generated kernel (library == filepath) or a backend plugin reading
+// `filepath`. Backend plugins are never unloaded, their runtimes do not support it.
+class PluginPolicyBackend : public PolicyBackend
+{
+public:
+  PluginPolicyBackend(
+    const std::string & library, const std::string & filepath, size_t observation_size)
+  {
+    const int flags = RTLD_NOW | RTLD_LOCAL | (library != filepath ? RTLD_NODELETE : 0);
+    handle_ = dlopen(library.c_str(), flags);
+    if (!handle_) {
+      throw std::runtime_error("Cannot load policy plugin '" + library + "': " + dlerror());
+    }
+    auto abi = reinterpret_cast<PolicyBackendAbiFn>(
+      dlsym(handle_, "unitree_a1_neural_control_policy_backend_abi"));
+    auto create = reinterpret_cast<CreatePolicyBackendFn>(
+      dlsym(handle_, "unitree_a1_neural_control_create_policy_backend"));
+    if (!abi || !create || abi() != POLICY_BACKEND_ABI_VERSION) {
+      dlclose(handle_);
+      throw std::runtime_error("'" + library + "' is not a compatible policy plugin");
+    }
+    try {
+      backend_.reset(create(filepath.c_str(), observation_size));
+    } catch (...) {
+      dlclose(handle_);
+      throw;
+    }
+    if (backend_->observationSize() != observation_size) {
+      const size_t model_size = backend_->observationSize();
+      backend_.reset();
+      dlclose(handle_);
+      throw std::runtime_error(
+              "Policy '" + filepath + "' takes " + std::to_string(model_size) +
+              " observation values, the controller builds " + std::to_string(observation_size));
+    }
+  }
+  ~PluginPolicyBackend() override
+  {
+    backend_.reset();
+    dlclose(handle_);
+  }
+  void forward(const float * observation, float * action) override
+  {
+    backend_->forward(observation, action);
+  }
+  size_t observationSize() const override
+  {
+    return backend_->observationSize();
+  }
+  size_t actionSize() const override
+  {
+    return backend_->actionSize();
+  }
+
+private:
+  void * handle_;
+  PolicyBackendPtr backend_;
+};
+
+}  // namespace
+
+PolicyBackendPtr loadPolicyBackend(const std::string & filepath, size_t observation_size)
+{
+  auto start = std::chrono::steady_clock::now();
+  PolicyBackendPtr backend;
+  if (endsWith(filepath, ".so")) {
+    backend = std::make_unique<PluginPolicyBackend>(filepath, filepath, observation_size);
+  } else if (endsWith(filepath, ".npw")) {
+    backend = std::make_unique<NativePolicyBackend>(filepath, observation_size);
+  } else {
+    backend = std::make_unique<PluginPolicyBackend>(
+      TORCH_BACKEND_PLUGIN, filepath, observation_size);
+  }
+  auto warmup_start = std::chrono::steady_clock::now();
+  // Run a few forwards so the first control tick does not pay for lazy initialization
+  std::vector<float> observation(observation_size, 0.0f);
+  std::vector<float> action(backend->actionSize());
+  for (size_t i = 0; i < POLICY_WARMUP_ITERATIONS; i++) {
+    backend->forward(observation.data(), action.data());
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::milli> load_ms = end - start;
+  std::chrono::duration<double, std::milli> warmup_ms = end - warmup_start;
+  recordPolicyLoad(load_ms.count(), warmup_ms.count());
+  return backend;
+}
+
+}  // namespace unitree_a1_neural_control
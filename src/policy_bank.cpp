@@ -0,0 +1,167 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/policy_bank.hpp"
+
+#include <Eigen/Dense>
+#include <stdexcept>
+#include <string>
+
+namespace unitree_a1_neural_control
+{
+
+PolicyBank::PolicyBank(size_t observation_size)
+{
+  observation_size_ = observation_size;
+}
+
+void PolicyBank::add(const std::string & name, const std::string & path)
+{
+  for (auto & policy : policies_) {
+    if (policy.name == name) {
+      policy.path = path;
+      this->load(policy);
+      return;
+    }
+  }
+  policies_.push_back({name, path, nullptr, {}});
+  this->load(policies_.back());
+}
+
+void PolicyBank::reload()
+{
+  for (auto & policy : policies_) {
+    this->load(policy);
+  }
+}
+
+void PolicyBank::load(Policy & policy)
+{
+  policy.backend = loadPolicyBackend(policy.path, observation_size_);
+  policy.action.resize(policy.backend->actionSize());
+}
+
+void PolicyBank::setCrossfade(size_t crossfade_ticks, int cpu)
+{
+  crossfade_ticks_ = crossfade_ticks;
+  crossfade_remaining_ = 0;
+  if (crossfade_ticks_ > 0) {
+    worker_ = std::make_unique<InferenceWorker>(cpu);
+  } else {
+    worker_.reset();
+  }
+}
+
+bool PolicyBank::inTransition() const
+{
+  return crossfade_remaining_ > 0;
+}
+
+bool PolicyBank::select(const std::string & name)
+{
+  for (size_t i = 0; i < policies_.size(); i++) {
+    if (policies_[i].name == name) {
+      requested_.store(i, std::memory_order_release);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool PolicyBank::applySelection()
+{
+  size_t requested = requested_.load(std::memory_order_acquire);
+  if (requested == active_ || requested >= policies_.size()) {
+    return false;
+  }
+  // Restarting mid-fade would drop the blend and jump, the latest request waits for the end
+  if (crossfade_remaining_ > 0) {
+    return false;
+  }
+  // Nothing to fade from before the first forward
+  if (crossfade_ticks_ > 0 && started_) {
+    previous_ = active_;
+    crossfade_remaining_ = crossfade_ticks_;
+  }
+  active_ = requested;
+  return true;
+}
+
+const std::vector<float> & PolicyBank::forward(const std::vector<float> & state)
+{
+  if (policies_.empty()) {
+    throw std::runtime_error("Policy bank is empty");
+  }
+  // Backends read exactly observation_size_ values, never a prefix or past the end
+  if (state.size() != observation_size_) {
+    throw std::invalid_argument(
+            "Observation has " + std::to_string(state.size()) + " values, policies take " +
+            std::to_string(observation_size_));
+  }
+  started_ = true;
+  auto & active = policies_[active_];
+  if (crossfade_remaining_ == 0) {
+    active.backend->forward(state.data(), active.action.data());
+    return active.action;
+  }
+  // Previous policy runs on the worker core while the new one runs here
+  auto & previous = policies_[previous_];
+  if (previous.action.size() != active.action.size()) {
+    throw std::runtime_error("Cannot crossfade policies with different output sizes");
+  }
+  worker_->submit(
+    [&previous, &state]() {
+      previous.backend->forward(state.data(), previous.action.data());
+    });
+  try {
+    active.backend->forward(state.data(), active.action.data());
+  } catch (...) {
+    // The job reads `state`, it has to finish before the exception leaves this call
+    try {
+      worker_->wait();
+    } catch (...) {
+    }
+    throw;
+  }
+  worker_->wait();
+  // Linear blend from the previous to the new policy, vectorized by Eigen
+  const float weight = 1.0f - static_cast<float>(crossfade_remaining_) /
+    static_cast<float>(crossfade_ticks_ + 1);
+  Eigen::Map<const Eigen::ArrayXf> from(previous.action.data(), previous.action.size());
+  Eigen::Map<Eigen::ArrayXf> to(active.action.data(), active.action.size());
+  to = from + weight * (to - from);
+  crossfade_remaining_--;
+  return active.action;
+}
+
+std::string PolicyBank::activeName() const
+{
+  return policies_.empty() ? std::string() : policies_[active_].name;
+}
+
+std::vector<std::string> PolicyBank::names() const
+{
+  std::vector<std::string> names;
+  for (const auto & policy : policies_) {
+    names.push_back(policy.name);
+  }
+  return names;
+}
+
+size_t PolicyBank::size() const
+{
+  return policies_.size();
+}
+
+}  // namespace unitree_a1_neural_control
@@ -0,0 +1,126 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/policy_cache.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "unitree_a1_neural_control/policy_backend.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+namespace
+{
+
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+uint64_t fnv1a(const char * data, size_t size, uint64_t hash)
+{
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+std::mutex cache_mutex;
+std::string cache_directory;
+PolicyLoadStats load_stats;
+
+}  // namespace
+
+void setPolicyCacheDirectory(const std::string & directory)
+{
+  if (!directory.empty()) {
+    std::filesystem::create_directories(directory);
+  }
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  cache_directory = directory;
+}
+
+std::string getPolicyCacheDirectory()
+{
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  return cache_directory;
+}
+
+uint64_t hashPolicyFile(const std::string & filepath)
+{
+  std::ifstream file(filepath, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Cannot open policy '" + filepath + "'");
+  }
+  uint64_t hash = FNV_OFFSET_BASIS;
+  std::vector<char> buffer(1 << 16);
+  while (file) {
+    file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    hash = fnv1a(buffer.data(), static_cast<size_t>(file.gcount()), hash);
+  }
+  return hash;
+}
+
+std::string policyCachePath(const std::string & filepath, const std::string & runtime)
+{
+  const std::string directory = getPolicyCacheDirectory();
+  if (directory.empty()) {
+    return {};
+  }
+  // Runtime and backend ABI are part of the key
+  const std::string runtime_key = runtime + "/" + std::to_string(POLICY_BACKEND_ABI_VERSION);
+  uint64_t key = fnv1a(runtime_key.data(), runtime_key.size(), hashPolicyFile(filepath));
+  char name[17];
+  std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+  const std::filesystem::path source(filepath);
+  return (std::filesystem::path(directory) /
+         (source.stem().string() + "-" + name + source.extension().string())).string();
+}
+
+void recordPolicyCacheLookup(bool hit)
+{
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  if (hit) {
+    load_stats.cache_hits++;
+  } else {
+    load_stats.cache_misses++;
+  }
+}
+
+void recordPolicyLoad(double load_ms, double warmup_ms)
+{
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  load_stats.loads++;
+  load_stats.last_load_ms = load_ms;
+  load_stats.total_load_ms += load_ms;
+  load_stats.total_warmup_ms += warmup_ms;
+}
+
+void recordPolicyOptimize(double optimize_ms)
+{
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  load_stats.total_optimize_ms += optimize_ms;
+}
+
+PolicyLoadStats getPolicyLoadStats()
+{
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  return load_stats;
+}
+
+}  // namespace unitree_a1_neural_control
@@ -0,0 +1,150 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/policy_ensemble.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace unitree_a1_neural_control
+{
+
+PolicyEnsemble::PolicyEnsemble(
+  const std::vector<std::string> & filepaths, size_t observation_size,
+  EnsembleMode mode, size_t batched_size, EnsembleReduction reduction,
+  const std::vector<int> & cpus)
+{
+  if (filepaths.empty()) {
+    throw std::invalid_argument("Policy ensemble needs at least one model");
+  }
+  mode_ = mode;
+  reduction_ = reduction;
+  if (mode_ == EnsembleMode::BATCHED) {
+    if (filepaths.size() != 1 || batched_size == 0) {
+      throw std::invalid_argument("Batched ensemble needs exactly one model and a member count");
+    }
+    members_count_ = batched_size;
+  } else {
+    members_count_ = filepaths.size();
+  }
+  for (const auto & path : filepaths) {
+    backends_.push_back(loadPolicyBackend(path, observation_size));
+    if (backends_.back()->actionSize() != backends_.front()->actionSize()) {
+      throw std::invalid_argument("Ensemble members have different output sizes");
+    }
+  }
+  const size_t output_size = backends_.front()->actionSize();
+  if (output_size % (mode_ == EnsembleMode::BATCHED ? members_count_ : 1) != 0) {
+    throw std::invalid_argument("Batched ensemble output is not divisible by the member count");
+  }
+  action_size_ = mode_ == EnsembleMode::BATCHED ? output_size / members_count_ : output_size;
+  if (mode_ == EnsembleMode::PARALLEL) {
+    if (cpus.size() >= backends_.size()) {
+      throw std::invalid_argument(
+              "Ensemble has " + std::to_string(backends_.size() - 1) + " worker thread(s), got " +
+              std::to_string(cpus.size()) + " cpu(s)");
+    }
+    // The control thread evaluates the first member itself
+    for (size_t i = 1; i < backends_.size(); i++) {
+      workers_.push_back(std::make_unique<InferenceWorker>(i <= cpus.size() ? cpus[i - 1] : -1));
+      jobs_.push_back(
+        [this, i]() {
+          backends_[i]->forward(state_, members_.row(i).data());
+        });
+    }
+  }
+  // Buffers are sized once so the control loop never allocates
+  members_.resize(members_count_, action_size_);
+  mean_.resize(action_size_);
+  column_.resize(members_count_);
+  action_.resize(action_size_);
+  spread_.resize(action_size_);
+}
+
+void PolicyEnsemble::gather(const std::vector<float> & state)
+{
+  if (mode_ == EnsembleMode::BATCHED) {
+    // Row-major [M, action_size] output lands directly in the member matrix
+    backends_[0]->forward(state.data(), members_.data());
+    return;
+  }
+  std::exception_ptr error;
+  state_ = state.data();
+  try {
+    // A std::function holding a reference_wrapper never allocates
+    for (size_t i = 0; i < workers_.size(); i++) {
+      workers_[i]->submit(std::ref(jobs_[i]));
+    }
+    backends_[0]->forward(state.data(), members_.row(0).data());
+  } catch (...) {
+    error = std::current_exception();
+  }
+  // Jobs read `state` and write members_, all of them finish before anything propagates
+  for (auto & worker : workers_) {
+    try {
+      worker->wait();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+const std::vector<float> & PolicyEnsemble::forward(const std::vector<float> & state)
+{
+  this->gather(state);
+  const auto cols = members_.cols();
+  Eigen::Map<Eigen::RowVectorXf> reduced(action_.data(), cols);
+  mean_ = members_.colwise().mean();
+  if (reduction_ == EnsembleReduction::MEDIAN) {
+    const size_t middle = members_count_ / 2;
+    for (Eigen::Index j = 0; j < cols; j++) {
+      for (size_t i = 0; i < members_count_; i++) {
+        column_[i] = members_(i, j);
+      }
+      std::nth_element(column_.begin(), column_.begin() + middle, column_.end());
+      float median = column_[middle];
+      if (members_count_ % 2 == 0) {
+        median = 0.5f * (median + *std::max_element(column_.begin(), column_.begin() + middle));
+      }
+      reduced(j) = median;
+    }
+  } else {
+    reduced = mean_;
+  }
+  // Spread across members, population standard deviation
+  Eigen::Map<Eigen::RowVectorXf> spread(spread_.data(), cols);
+  spread = ((members_.rowwise() - mean_).array().square().colwise().sum() /
+    static_cast<float>(members_count_)).sqrt().matrix();
+  return action_;
+}
+
+const std::vector<float> & PolicyEnsemble::getSpread() const
+{
+  return spread_;
+}
+
+size_t PolicyEnsemble::size() const
+{
+  return members_count_;
+}
+
+}  // namespace unitree_a1_neural_control
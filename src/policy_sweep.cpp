@@ -0,0 +1,272 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Offline policy sweep. Evaluates a policy over a grid of synthetic observations
+// (cmd_vel x orientation x foot contact pattern) or over a raw float32 [N, 53] dataset and
+// writes every row as [observation, action] into a memory-mapped output file:
+//
+//   unitree_a1_neural_control_policy_sweep --model policy.pt --output sweep.bin
+//     [--vx -1:1:21] [--vy -0.5:0.5:11] [--wz -1:1:21] [--roll -0.3:0.3:7]
+//     [--pitch -0.3:0.3:7] [--dataset observations.bin] [--batch 4096]
+//
+// The output starts with a SweepHeader followed by `rows` rows of
+// observation_size + action_size floats.
+
+#include <ATen/Parallel.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "unitree_a1_neural_control/torch_policy_backend.hpp"
+#include "unitree_a1_neural_control/unitree_a1_neural_control.hpp"
+
+using unitree_a1_neural_control::OBS_SIZE;
+
+namespace
+{
+
+struct SweepHeader
+{
+  char magic[8] = {'A', '1', 'S', 'W', 'E', 'E', 'P', '\0'};
+  uint32_t version = 1;
+  uint32_t observation_size = 0;
+  uint32_t action_size = 0;
+  uint32_t reserved = 0;
+  uint64_t rows = 0;
+};
+
+struct Axis
+{
+  float min;
+  float max;
+  int64_t steps;
+  float at(int64_t i) const
+  {
+    return steps > 1 ? min + (max - min) * static_cast<float>(i) / static_cast<float>(steps - 1) :
+           min;
+  }
+};
+
+Axis parseAxis(const std::string & spec)
+{
+  Axis axis{};
+  if (std::sscanf(spec.c_str(), "%f:%f:%ld", &axis.min, &axis.max, &axis.steps) != 3 ||
+    axis.steps < 1)
+  {
+    throw std::invalid_argument("Axis has to be min:max:steps, got '" + spec + "'");
+  }
+  return axis;
+}
+
+class MappedFile
+{
+public:
+  MappedFile(const std::string & path, size_t size, bool writable)
+  {
+    fd_ = writable ? ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) :
+      ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+      throw std::runtime_error("Cannot open '" + path + "'");
+    }
+    if (writable) {
+      if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+        ::close(fd_);
+        throw std::runtime_error("Cannot resize '" + path + "'");
+      }
+    } else {
+      struct stat st;
+      if (::fstat(fd_, &st) != 0) {
+        ::close(fd_);
+        throw std::runtime_error("Cannot read the size of '" + path + "'");
+      }
+      size = static_cast<size_t>(st.st_size);
+    }
+    size_ = size;
+    data_ = ::mmap(
+      nullptr, size_, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, 0);
+    if (data_ == MAP_FAILED) {
+      ::close(fd_);
+      throw std::runtime_error("Cannot map '" + path + "'");
+    }
+  }
+  ~MappedFile()
+  {
+    ::msync(data_, size_, MS_SYNC);
+    ::munmap(data_, size_);
+    ::close(fd_);
+  }
+  void * data() const {return data_;}
+  size_t size() const {return size_;}
+
+private:
+  int fd_;
+  size_t size_;
+  void * data_;
+};
+
+// Synthetic observation for the policy: nominal joint pose, robot at rest, requested goal
+// velocity, orientation and contact pattern (bit i set = foot i in contact, FL/FR/RL/RR).
+void fillGridObservation(
+  float * obs, float vx, float vy, float wz, float roll, float pitch, int64_t contacts)
+{
+  std::fill(obs, obs + OBS_SIZE, 0.0f);
+  using namespace unitree_a1_neural_control;
+  obs[OBS_GOAL_VELOCITY + 0] = vx;
+  obs[OBS_GOAL_VELOCITY + 1] = vy;
+  obs[OBS_GOAL_VELOCITY + 2] = wz;
+  for (size_t foot = 0; foot < Robot::LEG_COUNT; foot++) {
+    obs[OBS_FOOT_CONTACT + foot] = ((contacts >> foot) & 1) ? 1.0f : 0.0f;
+  }
+  // Same convention as UnitreeNeuralControl::convertToGravityVector
+  Quaternionf orientation =
+    Eigen::AngleAxisf(roll, Vector3f::UnitX()) * Eigen::AngleAxisf(pitch, Vector3f::UnitY());
+  Vector3f gravity = orientation.toRotationMatrix() * Vector3f(0.0f, 0.0f, -1.0f);
+  gravity.normalize();
+  obs[OBS_GRAVITY + 0] = gravity.x();
+  obs[OBS_GRAVITY + 1] = gravity.y();
+  obs[OBS_GRAVITY + 2] = gravity.z();
+}
+
+void printUsage()
+{
+  std::cerr <<
+    "Usage: unitree_a1_neural_control_policy_sweep --model <policy.pt> --output <file>\n"
+    "  [--vx min:max:steps] [--vy min:max:steps] [--wz min:max:steps]\n"
+    "  [--roll min:max:steps] [--pitch min:max:steps]\n"
+    "  [--dataset <float32 [N, 53] file>] [--batch <rows per forward>]\n";
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  std::map<std::string, std::string> args = {
+    {"--vx", "-1:1:21"}, {"--vy", "-0.5:0.5:11"}, {"--wz", "-1:1:21"},
+    {"--roll", "-0.3:0.3:7"}, {"--pitch", "-0.3:0.3:7"}, {"--batch", "4096"}};
+  for (int i = 1; i + 1 < argc; i += 2) {
+    args[argv[i]] = argv[i + 1];
+  }
+  if (!args.count("--model") || !args.count("--output")) {
+    printUsage();
+    return 1;
+  }
+  try {
+    auto module = unitree_a1_neural_control::loadPolicyModule(args["--model"]);
+    const int64_t batch = std::max<int64_t>(std::stol(args["--batch"]), 1);
+    // Input rows, either a grid or a dataset
+    std::unique_ptr<MappedFile> dataset;
+    const float * dataset_rows = nullptr;
+    Axis vx{}, vy{}, wz{}, roll{}, pitch{};
+    constexpr int64_t contact_patterns = 16;
+    int64_t rows;
+    if (args.count("--dataset")) {
+      dataset = std::make_unique<MappedFile>(args["--dataset"], 0, false);
+      dataset_rows = static_cast<const float *>(dataset->data());
+      rows = static_cast<int64_t>(dataset->size() / (OBS_SIZE * sizeof(float)));
+    } else {
+      vx = parseAxis(args["--vx"]);
+      vy = parseAxis(args["--vy"]);
+      wz = parseAxis(args["--wz"]);
+      roll = parseAxis(args["--roll"]);
+      pitch = parseAxis(args["--pitch"]);
+      rows = vx.steps * vy.steps * wz.steps * roll.steps * pitch.steps * contact_patterns;
+    }
+    // Output width is taken from the policy itself
+    c10::InferenceMode guard;
+    const auto action_size = static_cast<size_t>(
+      module.forward({torch::zeros({1, static_cast<long>(OBS_SIZE)})}).toTensor().numel());
+    const size_t row_size = OBS_SIZE + action_size;
+    MappedFile output(
+      args["--output"], sizeof(SweepHeader) + static_cast<size_t>(rows) * row_size * sizeof(float),
+      true);
+    SweepHeader header;
+    header.observation_size = static_cast<uint32_t>(OBS_SIZE);
+    header.action_size = static_cast<uint32_t>(action_size);
+    header.rows = static_cast<uint64_t>(rows);
+    std::memcpy(output.data(), &header, sizeof(header));
+    float * out = reinterpret_cast<float *>(static_cast<char *>(output.data()) + sizeof(header));
+
+    std::cout << "Sweeping " << rows << " rows, batch " << batch << ", " <<
+      at::get_num_threads() << " threads" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    const int64_t batches = (rows + batch - 1) / batch;
+    // One batch per task, nested torch parallelism runs inline inside the region
+    at::parallel_for(
+      0, batches, 1, [&](int64_t begin, int64_t end) {
+        c10::InferenceMode guard;
+        for (int64_t b = begin; b < end; b++) {
+          const int64_t first = b * batch;
+          const int64_t count = std::min(batch, rows - first);
+          float * block = out + first * static_cast<int64_t>(row_size);
+          for (int64_t r = 0; r < count; r++) {
+            float * obs = block + r * static_cast<int64_t>(row_size);
+            const int64_t index = first + r;
+            if (dataset_rows) {
+              std::memcpy(obs, dataset_rows + index * OBS_SIZE, OBS_SIZE * sizeof(float));
+              continue;
+            }
+            int64_t rest = index;
+            const int64_t contacts = rest % contact_patterns; rest /= contact_patterns;
+            const int64_t ip = rest % pitch.steps; rest /= pitch.steps;
+            const int64_t ir = rest % roll.steps; rest /= roll.steps;
+            const int64_t iw = rest % wz.steps; rest /= wz.steps;
+            const int64_t iy = rest % vy.steps; rest /= vy.steps;
+            fillGridObservation(
+              obs, vx.at(rest), vy.at(iy), wz.at(iw), roll.at(ir), pitch.at(ip), contacts);
+          }
+          // Observations are read in place, rows are strided by the action columns
+          auto input = torch::from_blob(
+            block, {count, static_cast<long>(OBS_SIZE)}, {static_cast<long>(row_size), 1});
+          at::Tensor action = module.forward({input.contiguous()}).toTensor().contiguous();
+          // Outputs that do not scale with the batch, e.g. squeezed or chunked, would be read
+          // out of bounds
+          if (action.dim() == 0 || action.size(0) != count ||
+            action.numel() != count * static_cast<int64_t>(action_size) ||
+            action.scalar_type() != torch::kFloat)
+          {
+            throw std::runtime_error(
+                    "Policy output of " + std::to_string(action.numel()) +
+                    " values for a batch of " + std::to_string(count) +
+                    " rows, expected float32 [" + std::to_string(count) + ", " +
+                    std::to_string(action_size) + "]");
+          }
+          const float * action_data = action.data_ptr<float>();
+          for (int64_t r = 0; r < count; r++) {
+            std::memcpy(
+              block + r * static_cast<int64_t>(row_size) + OBS_SIZE,
+              action_data + r * static_cast<int64_t>(action_size), action_size * sizeof(float));
+          }
+        }
+      });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Wrote " << rows << " rows to '" << args["--output"] << "' in " <<
+      elapsed.count() << " s (" << static_cast<double>(rows) / elapsed.count() << " rows/s)" <<
+      std::endl;
+  } catch (const std::exception & e) {
+    std::cerr << "Policy sweep failed: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/sensor_pre_filter.hpp"
+
+#include <stdexcept>
+
+namespace unitree_a1_neural_control
+{
+
+MotorStateTable motorStateTable(const unitree_a1_legged_msgs::msg::QuadrupedState & leg)
+{
+  return {
+    &leg.front_right.hip, &leg.front_right.thigh, &leg.front_right.calf,
+    &leg.front_left.hip, &leg.front_left.thigh, &leg.front_left.calf,
+    &leg.rear_right.hip, &leg.rear_right.thigh, &leg.rear_right.calf,
+    &leg.rear_left.hip, &leg.rear_left.thigh, &leg.rear_left.calf};
+}
+
+std::array<MotorState *, JOINT_COUNT> motorStateTable(
+  unitree_a1_legged_msgs::msg::QuadrupedState & leg)
+{
+  return {
+    &leg.front_right.hip, &leg.front_right.thigh, &leg.front_right.calf,
+    &leg.front_left.hip, &leg.front_left.thigh, &leg.front_left.calf,
+    &leg.rear_right.hip, &leg.rear_right.thigh, &leg.rear_right.calf,
+    &leg.rear_left.hip, &leg.rear_left.thigh, &leg.rear_left.calf};
+}
+
+void SensorFilterConfig::validate() const
+{
+  if (!(dq_alpha > 0.0f && dq_alpha <= 1.0f)) {
+    throw std::invalid_argument("Joint velocity filter weight has to be in (0, 1]");
+  }
+  contact.validate();
+}
+
+SensorPreFilter::SensorPreFilter(const SensorFilterConfig & config)
+{
+  this->setConfig(config);
+}
+
+void SensorPreFilter::setConfig(const SensorFilterConfig & config)
+{
+  config.validate();
+  dq_alpha_ = config.dq_alpha;
+  contact_.setConfig(config.contact);
+}
+
+void SensorPreFilter::update(
+  const sensor_msgs::msg::Imu & imu, const unitree_a1_legged_msgs::msg::LowState & state)
+{
+  snapshot_.samples++;
+  snapshot_.angular_velocity_sum[0] += imu.angular_velocity.x;
+  snapshot_.angular_velocity_sum[1] += imu.angular_velocity.y;
+  snapshot_.angular_velocity_sum[2] += imu.angular_velocity.z;
+  // The first sample initialises the filter
+  const auto motors = motorStateTable(state.motor_state);
+  const float alpha = snapshot_.samples == 1 ? 1.0f : dq_alpha_;
+  for (size_t i = 0; i < JOINT_COUNT; i++) {
+    snapshot_.dq[i] += alpha * (static_cast<float>(motors[i]->dq) - snapshot_.dq[i]);
+  }
+  const auto & foot = state.foot_force;
+  contact_.update(
+    {static_cast<float>(foot.front_right), static_cast<float>(foot.front_left),
+      static_cast<float>(foot.rear_right), static_cast<float>(foot.rear_left)});
+  snapshot_.contact = contact_.contact();
+}
+
+const SensorSnapshot & SensorPreFilter::snapshot() const
+{
+  return snapshot_;
+}
+
+void SensorPreFilter::reset()
+{
+  contact_.reset();
+  snapshot_ = SensorSnapshot();
+}
+
+}  // namespace unitree_a1_neural_control
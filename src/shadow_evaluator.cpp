@@ -0,0 +1,129 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/shadow_evaluator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include "unitree_a1_neural_control/inference_worker.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+ShadowEvaluator::ShadowEvaluator(
+  const std::string & filepath, size_t observation_size, size_t action_size, int cpu,
+  ShadowCallback callback)
+{
+  backend_ = loadPolicyBackend(filepath, observation_size);
+  action_size_ = action_size;
+  output_.resize(backend_->actionSize());
+  callback_ = std::move(callback);
+  // Buffers are sized once so posting a snapshot never allocates
+  snapshot_.state.resize(observation_size);
+  snapshot_.active_action.resize(action_size);
+  result_.state.resize(observation_size);
+  result_.active_action.resize(action_size);
+  result_.shadow_action.resize(action_size);
+  thread_ = std::thread(&ShadowEvaluator::run, this);
+  configureWorkerThread(thread_, cpu, true);
+}
+
+ShadowEvaluator::~ShadowEvaluator()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+void ShadowEvaluator::post(
+  const std::vector<float> & state,
+  const std::vector<float> & active_action)
+{
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (!lock.owns_lock() || pending_ || state.size() != snapshot_.state.size() ||
+    active_action.size() != snapshot_.active_action.size())
+  {
+    dropped_++;
+    return;
+  }
+  std::copy(state.begin(), state.end(), snapshot_.state.begin());
+  std::copy(active_action.begin(), active_action.end(), snapshot_.active_action.begin());
+  pending_ = true;
+  lock.unlock();
+  cv_.notify_one();
+}
+
+ShadowStats ShadowEvaluator::getStats() const
+{
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  auto stats = stats_;
+  stats.dropped = dropped_.load();
+  return stats;
+}
+
+void ShadowEvaluator::run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] {return pending_ || stop_;});
+    if (stop_) {
+      return;
+    }
+    std::swap(snapshot_.state, result_.state);
+    std::swap(snapshot_.active_action, result_.active_action);
+    lock.unlock();
+    try {
+      this->evaluate();
+    } catch (const std::exception &) {
+      // A broken candidate must not take the controller down
+      dropped_++;
+    }
+    lock.lock();
+    pending_ = false;
+  }
+}
+
+void ShadowEvaluator::evaluate()
+{
+  backend_->forward(result_.state.data(), output_.data());
+  // Only the first action of a chunk is compared against the executed one
+  const size_t size = std::min(action_size_, output_.size());
+  std::fill(result_.shadow_action.begin(), result_.shadow_action.end(), 0.0f);
+  std::copy(output_.begin(), output_.begin() + size, result_.shadow_action.begin());
+  double sum = 0.0;
+  double max = 0.0;
+  for (size_t i = 0; i < action_size_; i++) {
+    const double diff = std::abs(result_.shadow_action[i] - result_.active_action[i]);
+    sum += diff * diff;
+    max = std::max(max, diff);
+  }
+  result_.divergence_l2 = std::sqrt(sum);
+  result_.divergence_max = max;
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.evaluated++;
+    stats_.mean_divergence_l2 +=
+      (result_.divergence_l2 - stats_.mean_divergence_l2) / static_cast<double>(stats_.evaluated);
+    stats_.max_divergence = std::max(stats_.max_divergence, max);
+  }
+  if (callback_) {
+    callback_(result_);
+  }
+}
+
+}  // namespace unitree_a1_neural_control
@@ -0,0 +1,123 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Startup and footprint benchmark of the controller. Constructs UnitreeNeuralControl the way
+// the node does (backend load + warm-up) and reports resident memory and timings, so the
+// torch and the torch-free build variants can be compared on the same policy:
+//
+//   unitree_a1_neural_control_startup_benchmark --model policy.npw [--ticks 1000]
+//
+// A .pt model pulls in the TorchScript plugin and therefore libtorch; .npw and .so models
+// never map it.
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "unitree_a1_neural_control/policy_cache.hpp"
+#include "unitree_a1_neural_control/unitree_a1_neural_control.hpp"
+
+namespace
+{
+
+long residentMemoryKb()
+{
+  std::ifstream status("/proc/self/status");
+  std::string key;
+  while (status >> key) {
+    if (key == "VmRSS:") {
+      long rss_kb = 0;
+      status >> rss_kb;
+      return rss_kb;
+    }
+    status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  }
+  return 0;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).
+         count();
+}
+
+bool torchLoaded()
+{
+  return dlopen("libtorch_cpu.so", RTLD_NOW | RTLD_NOLOAD) != nullptr;
+}
+
+void printUsage()
+{
+  std::cerr <<
+    "Usage: unitree_a1_neural_control_startup_benchmark --model <policy> [--ticks <count>]\n";
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  using namespace unitree_a1_neural_control;
+  std::map<std::string, std::string> args = {{"--ticks", "1000"}};
+  for (int i = 1; i + 1 < argc; i += 2) {
+    args[argv[i]] = argv[i + 1];
+  }
+  if (!args.count("--model")) {
+    printUsage();
+    return 1;
+  }
+  try {
+    const long ticks = std::max(std::stol(args["--ticks"]), 1L);
+    const long start_rss_kb = residentMemoryKb();
+    auto start = std::chrono::steady_clock::now();
+    UnitreeNeuralControl controller(args["--model"], 20, Robot::NOMINAL);
+    const double construct_ms = elapsedMs(start);
+    const long loaded_rss_kb = residentMemoryKb();
+
+    auto goal = std::make_shared<geometry_msgs::msg::TwistStamped>();
+    auto imu = std::make_shared<sensor_msgs::msg::Imu>();
+    imu->orientation.w = 1.0;
+    auto state = std::make_shared<unitree_a1_legged_msgs::msg::LowState>();
+    start = std::chrono::steady_clock::now();
+    controller.modelForward(goal, imu, state);
+    const double first_forward_ms = elapsedMs(start);
+    start = std::chrono::steady_clock::now();
+    for (long i = 0; i < ticks; i++) {
+      controller.modelForward(goal, imu, state);
+    }
+    const double forward_ms = elapsedMs(start) / static_cast<double>(ticks);
+
+    const auto stats = getPolicyLoadStats();
+    std::cout << std::fixed << std::setprecision(3) <<
+      "libtorch mapped:      " << (torchLoaded() ? "yes" : "no") << "\n" <<
+      "startup (load+warm):  " << construct_ms << " ms (load " << stats.last_load_ms <<
+      " ms, warm-up " << stats.total_warmup_ms << " ms)\n" <<
+      "first forward:        " << first_forward_ms << " ms\n" <<
+      "mean forward:         " << forward_ms * 1000.0 << " us over " << ticks << " ticks\n" <<
+      "RSS before load:      " << start_rss_kb << " kB\n" <<
+      "RSS after load:       " << loaded_rss_kb << " kB\n" <<
+      "RSS after forwards:   " << residentMemoryKb() << " kB" << std::endl;
+  } catch (const std::exception & e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
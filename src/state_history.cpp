@@ -0,0 +1,187 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/state_history.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include "unitree_a1_neural_control/sensor_pre_filter.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+namespace
+{
+constexpr int READ_ATTEMPTS = 4;
+
+// Linear in every field, normalized linear for the quaternion along the shorter arc
+void interpolate(
+  const StateSample & a, const StateSample & b, int64_t target_ns, StateSample & out)
+{
+  const int64_t span = b.stamp_ns - a.stamp_ns;
+  const double t = span > 0 ? static_cast<double>(target_ns - a.stamp_ns) / span : 1.0;
+  const float tf = static_cast<float>(t);
+  out.stamp_ns = target_ns;
+  for (size_t i = 0; i < JOINT_COUNT; i++) {
+    out.q[i] = a.q[i] + tf * (b.q[i] - a.q[i]);
+    out.dq[i] = a.dq[i] + tf * (b.dq[i] - a.dq[i]);
+    out.tau_est[i] = a.tau_est[i] + tf * (b.tau_est[i] - a.tau_est[i]);
+  }
+  for (size_t i = 0; i < 3; i++) {
+    out.angular_velocity[i] =
+      a.angular_velocity[i] + t * (b.angular_velocity[i] - a.angular_velocity[i]);
+    out.linear_acceleration[i] =
+      a.linear_acceleration[i] + t * (b.linear_acceleration[i] - a.linear_acceleration[i]);
+  }
+  double dot = 0.0;
+  for (size_t i = 0; i < 4; i++) {
+    dot += a.orientation[i] * b.orientation[i];
+  }
+  const double sign = dot < 0.0 ? -1.0 : 1.0;
+  double norm = 0.0;
+  for (size_t i = 0; i < 4; i++) {
+    out.orientation[i] = a.orientation[i] + t * (sign * b.orientation[i] - a.orientation[i]);
+    norm += out.orientation[i] * out.orientation[i];
+  }
+  norm = std::sqrt(norm);
+  if (norm > 0.0) {
+    for (auto & value : out.orientation) {
+      value /= norm;
+    }
+  } else {
+    out.orientation = b.orientation;
+  }
+}
+}  // namespace
+
+void applyStateSample(
+  const StateSample & sample, sensor_msgs::msg::Imu & imu,
+  unitree_a1_legged_msgs::msg::LowState & state)
+{
+  const auto motors = motorStateTable(state.motor_state);
+  for (size_t i = 0; i < JOINT_COUNT; i++) {
+    motors[i]->q = sample.q[i];
+    motors[i]->dq = sample.dq[i];
+    motors[i]->tau_est = sample.tau_est[i];
+  }
+  for (auto * target : {&imu, &state.imu}) {
+    target->angular_velocity.x = sample.angular_velocity[0];
+    target->angular_velocity.y = sample.angular_velocity[1];
+    target->angular_velocity.z = sample.angular_velocity[2];
+    target->linear_acceleration.x = sample.linear_acceleration[0];
+    target->linear_acceleration.y = sample.linear_acceleration[1];
+    target->linear_acceleration.z = sample.linear_acceleration[2];
+    target->orientation.x = sample.orientation[0];
+    target->orientation.y = sample.orientation[1];
+    target->orientation.z = sample.orientation[2];
+    target->orientation.w = sample.orientation[3];
+  }
+}
+
+void StateHistory::push(
+  int64_t stamp_ns, const sensor_msgs::msg::Imu & imu,
+  const unitree_a1_legged_msgs::msg::LowState & state)
+{
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  if (head > 0 && stamp_ns <= stamps_[(head - 1) % CAPACITY].load(std::memory_order_relaxed)) {
+    return;
+  }
+  writing_.store(head, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  const size_t slot = head % CAPACITY;
+  StateSample sample;
+  sample.stamp_ns = stamp_ns;
+  const auto motors = motorStateTable(state.motor_state);
+  for (size_t i = 0; i < JOINT_COUNT; i++) {
+    sample.q[i] = static_cast<float>(motors[i]->q);
+    sample.dq[i] = static_cast<float>(motors[i]->dq);
+    sample.tau_est[i] = static_cast<float>(motors[i]->tau_est);
+  }
+  sample.angular_velocity = {
+    imu.angular_velocity.x, imu.angular_velocity.y, imu.angular_velocity.z};
+  sample.linear_acceleration = {
+    imu.linear_acceleration.x, imu.linear_acceleration.y, imu.linear_acceleration.z};
+  sample.orientation = {
+    imu.orientation.x, imu.orientation.y, imu.orientation.z, imu.orientation.w};
+  storeSlot(slot, sample);
+  stamps_[slot].store(stamp_ns, std::memory_order_relaxed);
+  head_.store(head + 1, std::memory_order_release);
+}
+
+bool StateHistory::sample(int64_t target_ns, StateSample & out) const
+{
+  StateSample older;
+  StateSample newer;
+  for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    if (head == 0) {
+      return false;
+    }
+    const uint64_t oldest = head > CAPACITY ? head - CAPACITY : 0;
+    // Newest sample at or before the target
+    uint64_t index = head - 1;
+    while (index > oldest &&
+      stamps_[index % CAPACITY].load(std::memory_order_relaxed) > target_ns)
+    {
+      index--;
+    }
+    const bool bracketed = index + 1 < head &&
+      stamps_[index % CAPACITY].load(std::memory_order_relaxed) <= target_ns;
+    loadSlot(index % CAPACITY, older);
+    if (bracketed) {
+      loadSlot((index + 1) % CAPACITY, newer);
+    }
+    // A slot is intact unless the writer started on the sample that replaces it
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (writing_.load(std::memory_order_relaxed) >= index + CAPACITY) {
+      continue;
+    }
+    if (bracketed) {
+      interpolate(older, newer, target_ns, out);
+    } else {
+      out = older;
+    }
+    return true;
+  }
+  return false;
+}
+
+void StateHistory::storeSlot(size_t slot, const StateSample & sample)
+{
+  static_assert(
+    std::is_trivially_copyable<StateSample>::value, "StateSample is copied bytewise");
+  std::array<uint64_t, SLOT_WORDS> words{};
+  std::memcpy(words.data(), &sample, sizeof(sample));
+  for (size_t i = 0; i < SLOT_WORDS; i++) {
+    slots_[slot][i].store(words[i], std::memory_order_relaxed);
+  }
+}
+
+void StateHistory::loadSlot(size_t slot, StateSample & sample) const
+{
+  std::array<uint64_t, SLOT_WORDS> words;
+  for (size_t i = 0; i < SLOT_WORDS; i++) {
+    words[i] = slots_[slot][i].load(std::memory_order_relaxed);
+  }
+  std::memcpy(static_cast<void *>(&sample), words.data(), sizeof(sample));
+}
+
+size_t StateHistory::size() const
+{
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  return static_cast<size_t>(head < CAPACITY ? head : CAPACITY);
+}
+
+}  // namespace unitree_a1_neural_control
@@ -0,0 +1,109 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unitree_a1_neural_control/torch_policy_backend.hpp"
+
+#include <torch/version.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include "unitree_a1_neural_control/policy_cache.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+torch::jit::script::Module loadPolicyModule(const std::string & path)
+{
+  // The frozen module is cached. optimize_for_inference may insert prepacked ops that cannot
+  // be serialized, so it runs on every load.
+  const std::string cached = policyCachePath(path, "torch-" TORCH_VERSION);
+  torch::jit::script::Module module;
+  bool hit = false;
+  if (!cached.empty() && std::ifstream(cached).good()) {
+    try {
+      module = torch::jit::load(cached);
+      module.eval();
+      hit = true;
+    } catch (const std::exception &) {
+      // Unreadable entry, rebuilt below
+    }
+  }
+  if (!hit) {
+    module = torch::jit::load(path);
+    module.eval();
+    auto freeze_start = std::chrono::steady_clock::now();
+    module = torch::jit::freeze(module);
+    std::chrono::duration<double, std::milli> freeze_ms =
+      std::chrono::steady_clock::now() - freeze_start;
+    recordPolicyOptimize(freeze_ms.count());
+    if (!cached.empty()) {
+      // Written aside and renamed so concurrent starts never read a partial entry
+      const std::string partial = cached + ".partial";
+      try {
+        module.save(partial);
+        std::rename(partial.c_str(), cached.c_str());
+      } catch (const std::exception &) {
+        std::remove(partial.c_str());
+      }
+    }
+  }
+  if (!cached.empty()) {
+    recordPolicyCacheLookup(hit);
+  }
+  auto optimize_start = std::chrono::steady_clock::now();
+  module = torch::jit::optimize_for_inference(module);
+  std::chrono::duration<double, std::milli> optimize_ms =
+    std::chrono::steady_clock::now() - optimize_start;
+  recordPolicyOptimize(optimize_ms.count());
+  return module;
+}
+
+TorchPolicyBackend::TorchPolicyBackend(const std::string & filepath, size_t observation_size)
+{
+  module_ = loadPolicyModule(filepath);
+  observation_size_ = observation_size;
+  // Output width is taken from the module itself
+  c10::InferenceMode guard;
+  auto zeros = torch::zeros({1, static_cast<long>(observation_size_)});
+  action_size_ = static_cast<size_t>(module_.forward({zeros}).toTensor().numel());
+}
+
+void TorchPolicyBackend::forward(const float * observation, float * action)
+{
+  c10::InferenceMode guard;
+  auto state = torch::from_blob(
+    const_cast<float *>(observation), {1, static_cast<long>(observation_size_)});
+  at::Tensor output = module_.forward({state}).toTensor().contiguous();
+  if (static_cast<size_t>(output.numel()) != action_size_) {
+    throw std::runtime_error("Policy output size changed between forwards");
+  }
+  std::copy(output.data_ptr<float>(), output.data_ptr<float>() + action_size_, action);
+}
+
+size_t TorchPolicyBackend::observationSize() const
+{
+  return observation_size_;
+}
+
+size_t TorchPolicyBackend::actionSize() const
+{
+  return action_size_;
+}
+
+}  // namespace unitree_a1_neural_control
+
+UNITREE_A1_NEURAL_CONTROL_EXPORT_POLICY_BACKEND(unitree_a1_neural_control::TorchPolicyBackend)
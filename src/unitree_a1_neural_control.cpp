@@ -14,6 +14,7 @@
 
 #include "unitree_a1_neural_control/unitree_a1_neural_control.hpp"
 
+#include <chrono>
 #include <iostream>
 
 namespace unitree_a1_neural_control
@@ -22,13 +23,17 @@ namespace unitree_a1_neural_control
 UnitreeNeuralControl::UnitreeNeuralControl(
   const std::string & filepath,
   int16_t foot_threshold,
-  std::array<float, 12> nominal_joint_position)
+  const JointArray & nominal_joint_position)
 {
   model_path_ = filepath;
   nominal_ = nominal_joint_position;
-  foot_contact_threshold_ = foot_threshold;
-  last_state_.resize(52);
-  last_action_.resize(12);
+  shared_parameters_.write(pending_parameters_);
+  this->setFootContactThreshold(foot_threshold);
+  parameters_ = pending_parameters_;
+  last_state_.resize(OBS_SIZE);
+  output_heads_ = {{OutputHead::POSITION, static_cast<float>(scaled_factor_)}};
+  post_processor_ = ActionPostProcessor(output_heads_, nominal_, joint_limits_);
+  last_action_.resize(post_processor_.actionSize());
   this->resetController();
 }
 
@@ -40,7 +45,11 @@ void UnitreeNeuralControl::resetController()
 
 void UnitreeNeuralControl::loadModel()
 {
-  module_ = torch::jit::load(model_path_);
+  if (policy_bank_.size() == 0) {
+    policy_bank_.add("default", model_path_);
+  } else {
+    policy_bank_.reload();
+  }
 }
 
 void UnitreeNeuralControl::getInputAndOutput(
@@ -54,33 +63,23 @@ void UnitreeNeuralControl::initValues()
 {
   std::fill(last_state_.begin(), last_state_.end(), 0.0f);
   std::fill(last_action_.begin(), last_action_.end(), 0.0f);
+  chunker_.reset();
+  idle_skipper_.reset();
+  post_processor_.reset();
+  leg_contact_.fill(0.0f);
+  leg_cycles_.fill(0.0f);
+  tick_contact_.reset();
 }
 
 unitree_a1_legged_msgs::msg::LowCmd UnitreeNeuralControl::modelForward(
   const geometry_msgs::msg::TwistStamped::SharedPtr goal,
   const unitree_a1_legged_msgs::msg::LowState::SharedPtr msg)
 {
+  // Latest gains and thresholds, fixed for the whole tick
+  parameters_ = shared_parameters_.read();
   // Convert msg to states
   auto state = this->msgToTensor(goal, msg);
-  // Copy state to last state for debug purposes
-  last_state_ = state;
-  // Convert vector to tensor
-  auto stateTensor = torch::from_blob(state.data(), {1, static_cast<long>(state.size())});
-  // Forward pass
-  at::Tensor action = module_.forward({stateTensor}).toTensor();
-  // Convert tensor to vector
-  std::vector<float> action_vec(action.data_ptr<float>(),
-    action.data_ptr<float>() + action.numel());
-  // Update last action
-  last_action_ = action_vec;
-  // Take nominal position and add action
-  std::transform(
-    nominal_.begin(), nominal_.end(),
-    action_vec.begin(), action_vec.begin(),
-    [&](double a, double b)
-    {return a + (b * scaled_factor_);});
-  // Convert to message
-  return this->actionToMsg(action_vec);
+  return this->stateForward(state);
 }
 
 unitree_a1_legged_msgs::msg::LowCmd UnitreeNeuralControl::modelForward(
@@ -88,27 +87,67 @@ unitree_a1_legged_msgs::msg::LowCmd UnitreeNeuralControl::modelForward(
   const sensor_msgs::msg::Imu::SharedPtr imu,
   const unitree_a1_legged_msgs::msg::LowState::SharedPtr msg)
 {
+  // Latest gains and thresholds, fixed for the whole tick
+  parameters_ = shared_parameters_.read();
   // Convert msg to states
   auto state = this->msgToTensor(goal, imu, msg);
+  return this->stateForward(state);
+}
+
+unitree_a1_legged_msgs::msg::LowCmd UnitreeNeuralControl::holdPose()
+{
+  parameters_ = shared_parameters_.read();
+  chunker_.reset();
+  idle_skipper_.reset();
+  unitree_a1_legged_msgs::msg::LowCmd cmd;
+  writeMotorCmds(
+    cmd, PMSM_SERVO_MODE, leg_mapping_.joints, post_processor_.output(OutputHead::POSITION),
+    parameters_.joint_kp.data(), parameters_.joint_kd.data(), parameters_.joint_tau.data());
+  this->initControlParams(cmd);
+  return cmd;
+}
+
+unitree_a1_legged_msgs::msg::LowCmd UnitreeNeuralControl::stateForward(
+  std::vector<float> & state)
+{
+  // Switch policy requested since the last tick, chunks of the previous policy are dropped
+  if (policy_bank_.applySelection()) {
+    chunker_.reset();
+    idle_skipper_.reset();
+  }
   // Copy state to last state for debug purposes
   last_state_ = state;
-  // Convert vector to tensor
-  auto stateTensor = torch::from_blob(state.data(), {1, static_cast<long>(state.size())});
-  // Forward pass
-  at::Tensor action = module_.forward({stateTensor}).toTensor();
-  // Convert tensor to vector
-  std::vector<float> action_vec(action.data_ptr<float>(),
-    action.data_ptr<float>() + action.numel());
+  std::vector<float> action_vec;
+  // Forward pass only when the current chunk is exhausted
+  if (chunker_.needsInference()) {
+    if (!policy_bank_.inTransition() && idle_skipper_.shouldSkip(state)) {
+      // Steady state, reuse the last action
+      action_vec = last_action_;
+    } else {
+      auto start = std::chrono::steady_clock::now();
+      // An ensemble, when configured, replaces the active bank policy
+      const auto & action = ensemble_ ?
+        ensemble_->forward(state) : policy_bank_.forward(state);
+      chunker_.pushChunk(action.data(), action.size());
+      std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+      idle_skipper_.recordInference(state, elapsed.count());
+    }
+  }
+  // Take the action for this tick from the chunk
+  if (action_vec.empty()) {
+    chunker_.nextAction(action_vec);
+  }
+  // Candidate policy sees the same observation, never blocks this thread
+  if (shadow_) {
+    shadow_->post(state, action_vec);
+  }
   // Update last action
   last_action_ = action_vec;
-  // Take nominal position and add action
-  std::transform(
-    nominal_.begin(), nominal_.end(),
-    action_vec.begin(), action_vec.begin(),
-    [&](double a, double b)
-    {return a + (b * scaled_factor_);});
+  // Scale, offset and clamp every output head in one pass
+  post_processor_.process(action_vec.data());
   // Convert to message
-  return this->actionToMsg(action_vec);
+  return this->actionToMsg(post_processor_);
 }
 
 std::vector<float> UnitreeNeuralControl::msgToTensor(
@@ -116,32 +155,36 @@ std::vector<float> UnitreeNeuralControl::msgToTensor(
   const unitree_a1_legged_msgs::msg::LowState::SharedPtr msg)
 {
   std::vector<float> tensor;
+  // Latest sensor-rate estimates
+  this->readSensors(*msg);
   // Joint positions
   auto position = this->pushJointPositions(msg->motor_state);
   tensor.insert(tensor.end(), position.begin(), position.end());
   // Imu angular velocity
-  tensor.push_back(msg->imu.angular_velocity.x);
-  tensor.push_back(msg->imu.angular_velocity.y);
-  tensor.push_back(msg->imu.angular_velocity.z);
+  if (parameters_.filtered_inputs) {
+    tensor.insert(
+      tensor.end(), window_angular_velocity_.begin(), window_angular_velocity_.end());
+  } else {
+    tensor.push_back(msg->imu.angular_velocity.x);
+    tensor.push_back(msg->imu.angular_velocity.y);
+    tensor.push_back(msg->imu.angular_velocity.z);
+  }
   // Joint velocities
-  this->pushJointVelocities(tensor, msg->motor_state.front_right);
-  this->pushJointVelocities(tensor, msg->motor_state.front_left);
-  this->pushJointVelocities(tensor, msg->motor_state.rear_right);
-  this->pushJointVelocities(tensor, msg->motor_state.rear_left);
+  this->pushJointVelocities(tensor, msg->motor_state);
   // Goal velocity
   tensor.push_back(goal->twist.linear.x);
   tensor.push_back(goal->twist.linear.y);
   tensor.push_back(goal->twist.angular.z);
-  // Convert foot force to contact
-  this->convertFootForceToContact(msg->foot_force);
   // Foot contact
   tensor.insert(tensor.end(), foot_contact_.begin(), foot_contact_.end());
   // Gravity vector
   auto gravity_vec =
     this->convertToGravityVector(msg->imu.orientation);
   tensor.insert(tensor.end(), gravity_vec.begin(), gravity_vec.end());
-  // Last action
-  tensor.insert(tensor.end(), last_action_.begin(), last_action_.end());
+  // Last action, position head only
+  const auto last_position = last_action_.begin() +
+    static_cast<std::ptrdiff_t>(post_processor_.offset(OutputHead::POSITION));
+  tensor.insert(tensor.end(), last_position, last_position + JOINT_COUNT);
   // Cycles since last contact
   this->updateCyclesSinceLastContact();
   tensor.insert(tensor.end(), cycles_since_last_contact_.begin(), cycles_since_last_contact_.end());
@@ -153,32 +196,36 @@ std::vector<float> UnitreeNeuralControl::msgToTensor(
   const unitree_a1_legged_msgs::msg::LowState::SharedPtr msg)
 {
   std::vector<float> tensor;
+  // Latest sensor-rate estimates
+  this->readSensors(*msg);
   // Joint positions
   auto position = this->pushJointPositions(msg->motor_state);
   tensor.insert(tensor.end(), position.begin(), position.end());
   // Imu angular velocity
-  tensor.push_back(imu->angular_velocity.x);
-  tensor.push_back(imu->angular_velocity.y);
-  tensor.push_back(imu->angular_velocity.z);
+  if (parameters_.filtered_inputs) {
+    tensor.insert(
+      tensor.end(), window_angular_velocity_.begin(), window_angular_velocity_.end());
+  } else {
+    tensor.push_back(imu->angular_velocity.x);
+    tensor.push_back(imu->angular_velocity.y);
+    tensor.push_back(imu->angular_velocity.z);
+  }
   // Joint velocities
-  this->pushJointVelocities(tensor, msg->motor_state.front_right);
-  this->pushJointVelocities(tensor, msg->motor_state.front_left);
-  this->pushJointVelocities(tensor, msg->motor_state.rear_right);
-  this->pushJointVelocities(tensor, msg->motor_state.rear_left);
+  this->pushJointVelocities(tensor, msg->motor_state);
   // Goal velocity
   tensor.push_back(goal->twist.linear.x);
   tensor.push_back(goal->twist.linear.y);
   tensor.push_back(goal->twist.angular.z);
-  // Convert foot force to contact
-  this->convertFootForceToContact(msg->foot_force);
   // Foot contact
   tensor.insert(tensor.end(), foot_contact_.begin(), foot_contact_.end());
   // Gravity vector
   auto gravity_vec =
     this->convertToGravityVector(imu->orientation);
   tensor.insert(tensor.end(), gravity_vec.begin(), gravity_vec.end());
-  // Last action
-  tensor.insert(tensor.end(), last_action_.begin(), last_action_.end());
+  // Last action, position head only
+  const auto last_position = last_action_.begin() +
+    static_cast<std::ptrdiff_t>(post_processor_.offset(OutputHead::POSITION));
+  tensor.insert(tensor.end(), last_position, last_position + JOINT_COUNT);
   // Cycles since last contact
   this->updateCyclesSinceLastContact();
   tensor.insert(tensor.end(), cycles_since_last_contact_.begin(), cycles_since_last_contact_.end());
@@ -186,54 +233,46 @@ std::vector<float> UnitreeNeuralControl::msgToTensor(
 }
 
 unitree_a1_legged_msgs::msg::LowCmd UnitreeNeuralControl::actionToMsg(
-  const std::vector<float> & action)
+  const ActionPostProcessor & processed)
 {
-  (void)action;
+  // Heads the policy does not output fall back to the configured joint gains
+  auto headOr = [&](OutputHead head, const JointArray & fallback) {
+      const float * values = processed.output(head);
+      return values ? values : fallback.data();
+    };
   unitree_a1_legged_msgs::msg::LowCmd cmd;
-  cmd.motor_cmd.front_right.hip.q = action[0];
-  cmd.motor_cmd.front_right.thigh.q = action[1];
-  cmd.motor_cmd.front_right.calf.q = action[2];
-  cmd.motor_cmd.front_left.hip.q = action[3];
-  cmd.motor_cmd.front_left.thigh.q = action[4];
-  cmd.motor_cmd.front_left.calf.q = action[5];
-  cmd.motor_cmd.rear_right.hip.q = action[6];
-  cmd.motor_cmd.rear_right.thigh.q = action[7];
-  cmd.motor_cmd.rear_right.calf.q = action[8];
-  cmd.motor_cmd.rear_left.hip.q = action[9];
-  cmd.motor_cmd.rear_left.thigh.q = action[10];
-  cmd.motor_cmd.rear_left.calf.q = action[11];
+  writeMotorCmds(
+    cmd, PMSM_SERVO_MODE, leg_mapping_.joints, processed.output(OutputHead::POSITION),
+    headOr(OutputHead::KP, parameters_.joint_kp), headOr(OutputHead::KD, parameters_.joint_kd),
+    headOr(OutputHead::TAU, parameters_.joint_tau));
   this->initControlParams(cmd);
   return cmd;
 }
-std::array<float, 12> UnitreeNeuralControl::pushJointPositions(
+JointArray UnitreeNeuralControl::pushJointPositions(
   const unitree_a1_legged_msgs::msg::QuadrupedState & leg)
 {
-  std::array<float, 12> pose;
-  pose[0] = leg.front_right.hip.q - nominal_[0];
-  pose[1] = leg.front_right.thigh.q - nominal_[1];
-  pose[2] = leg.front_right.calf.q - nominal_[2];
-
-  pose[3] = leg.front_left.hip.q - nominal_[3];
-  pose[4] = leg.front_left.thigh.q - nominal_[4];
-  pose[5] = leg.front_left.calf.q - nominal_[5];
-
-  pose[6] = leg.rear_right.hip.q - nominal_[6];
-  pose[7] = leg.rear_right.thigh.q - nominal_[7];
-  pose[8] = leg.rear_right.calf.q - nominal_[8];
-
-  pose[9] = leg.rear_left.hip.q - nominal_[9];
-  pose[10] = leg.rear_left.thigh.q - nominal_[10];
-  pose[11] = leg.rear_left.calf.q - nominal_[11];
+  const auto motors = motorStateTable(leg);
+  JointArray pose;
+  for (size_t i = 0; i < JOINT_COUNT; i++) {
+    pose[i] = motors[leg_mapping_.joints[i]]->q - nominal_[i];
+  }
   return pose;
 }
 
 void UnitreeNeuralControl::pushJointVelocities(
   std::vector<float> & tensor,
-  const unitree_a1_legged_msgs::msg::LegState & joint)
+  const unitree_a1_legged_msgs::msg::QuadrupedState & leg)
 {
-  tensor.push_back(joint.hip.dq);
-  tensor.push_back(joint.thigh.dq);
-  tensor.push_back(joint.calf.dq);
+  if (parameters_.filtered_inputs) {
+    for (size_t i = 0; i < JOINT_COUNT; i++) {
+      tensor.push_back(sensors_.dq[leg_mapping_.joints[i]]);
+    }
+    return;
+  }
+  const auto motors = motorStateTable(leg);
+  for (size_t i = 0; i < JOINT_COUNT; i++) {
+    tensor.push_back(motors[leg_mapping_.joints[i]]->dq);
+  }
 }
 std::vector<float> UnitreeNeuralControl::convertToGravityVector(
   const geometry_msgs::msg::Quaternion & orientation)
@@ -251,50 +290,229 @@ std::vector<float> UnitreeNeuralControl::convertToGravityVector(
     static_cast<float>(gravity_sensor.y()),
     static_cast<float>(gravity_sensor.z())};
 }
-void UnitreeNeuralControl::convertFootForceToContact(
-  const unitree_a1_legged_msgs::msg::FootForceState & foot)
+void UnitreeNeuralControl::updateSensors(
+  const sensor_msgs::msg::Imu & imu, const unitree_a1_legged_msgs::msg::LowState & state)
 {
-  auto convertFootForce = [&](const int16_t force)
-    {
-      return (force < foot_contact_threshold_) ? 0.0f : 1.0f;
-    };
-  foot_contact_[FL] = convertFootForce(foot.front_left);
-  foot_contact_[FR] = convertFootForce(foot.front_right);
-  foot_contact_[RL] = convertFootForce(foot.rear_left);
-  foot_contact_[RR] = convertFootForce(foot.rear_right);
+  pre_filter_.setConfig(shared_filter_config_.read());
+  pre_filter_.update(imu, state);
+  shared_sensors_.write(pre_filter_.snapshot());
+}
+
+void UnitreeNeuralControl::readSensors(const unitree_a1_legged_msgs::msg::LowState & msg)
+{
+  const auto & sensors = shared_sensors_.read();
+  // Mean over the samples since the previous tick, kept when none arrived
+  if (sensors.samples > sensors_.samples) {
+    const double count = static_cast<double>(sensors.samples - sensors_.samples);
+    for (size_t i = 0; i < window_angular_velocity_.size(); i++) {
+      window_angular_velocity_[i] = static_cast<float>(
+        (sensors.angular_velocity_sum[i] - sensors_.angular_velocity_sum[i]) / count);
+    }
+  }
+  sensors_ = sensors;
+  if (sensors_.samples > 0) {
+    leg_contact_ = sensors_.contact;
+  } else {
+    // Nothing at the sensor rate yet, estimate from the message of this tick
+    const auto & foot = msg.foot_force;
+    tick_contact_.setConfig(parameters_.contact);
+    tick_contact_.update(
+      {static_cast<float>(foot.front_right), static_cast<float>(foot.front_left),
+        static_cast<float>(foot.rear_right), static_cast<float>(foot.rear_left)});
+    leg_contact_ = tick_contact_.contact();
+  }
+  for (size_t i = 0; i < Robot::LEG_COUNT; i++) {
+    foot_contact_[i] = leg_contact_[leg_mapping_.contacts[i]];
+  }
 }
 
 void UnitreeNeuralControl::updateCyclesSinceLastContact()
 {
-  // for (size_t i = 0; i < foot_contact_.size(); i++) {
-  //   if (foot_contact_[i] == 1.0f) {
-  //     cycles_since_last_contact_[i] = 0.0f;
-  //   } else {
-  //     cycles_since_last_contact_[i] += 1.0f;
-  //   }
-  // }
-  // shit order:
-  cycles_since_last_contact_[FL_cycle] =
-    (foot_contact_[FL] == 1.0f) ? 0.0 : cycles_since_last_contact_[FL_cycle] + 1;
-  cycles_since_last_contact_[FR_cycle] =
-    (foot_contact_[FR] == 1.0f) ? 0.0 : cycles_since_last_contact_[FR_cycle] + 1;
-  cycles_since_last_contact_[RR_cycle] =
-    (foot_contact_[RR] == 1.0f) ? 0.0 : cycles_since_last_contact_[RR_cycle] + 1;
-  cycles_since_last_contact_[RL_cycle] =
-    (foot_contact_[RL] == 1.0f) ? 0.0 : cycles_since_last_contact_[RL_cycle] + 1;
+  // Counted per leg, reset on contact
+  for (size_t leg = 0; leg < Robot::LEG_COUNT; leg++) {
+    leg_cycles_[leg] = (leg_cycles_[leg] + 1.0f) * (1.0f - leg_contact_[leg]);
+  }
+  for (size_t i = 0; i < Robot::LEG_COUNT; i++) {
+    cycles_since_last_contact_[i] = leg_cycles_[leg_mapping_.cycles[i]];
+  }
 }
 
 void UnitreeNeuralControl::initControlParams(unitree_a1_legged_msgs::msg::LowCmd & cmd)
 {
-  cmd.common.mode = 0x0A;
-  cmd.common.kp = kp_;
-  cmd.common.kd = kd_;
-  // todo add common msg for different joints
+  cmd.common.mode = PMSM_SERVO_MODE;
+  cmd.common.kp = parameters_.kp;
+  cmd.common.kd = parameters_.kd;
 }
 void UnitreeNeuralControl::setGains(double kp, double kd)
 {
-  kp_ = kp;
-  kd_ = kd;
+  pending_parameters_.kp = kp;
+  pending_parameters_.kd = kd;
+  pending_parameters_.joint_kp.fill(static_cast<float>(kp));
+  pending_parameters_.joint_kd.fill(static_cast<float>(kd));
+  shared_parameters_.write(pending_parameters_);
+}
+
+void UnitreeNeuralControl::setJointGains(
+  const JointArray & kp, const JointArray & kd, const JointArray & tau)
+{
+  pending_parameters_.joint_kp = kp;
+  pending_parameters_.joint_kd = kd;
+  pending_parameters_.joint_tau = tau;
+  shared_parameters_.write(pending_parameters_);
+}
+
+void UnitreeNeuralControl::setGains(
+  double kp, double kd, const JointArray & joint_kp, const JointArray & joint_kd,
+  const JointArray & joint_tau)
+{
+  pending_parameters_.kp = kp;
+  pending_parameters_.kd = kd;
+  pending_parameters_.joint_kp = joint_kp;
+  pending_parameters_.joint_kd = joint_kd;
+  pending_parameters_.joint_tau = joint_tau;
+  shared_parameters_.write(pending_parameters_);
+}
+
+void UnitreeNeuralControl::setFootContactThreshold(int16_t threshold)
+{
+  foot_contact_threshold_ = threshold;
+  pending_filter_config_.contact = ContactEstimatorConfig::uniform(threshold);
+  shared_filter_config_.write(pending_filter_config_);
+  pending_parameters_.contact = pending_filter_config_.contact;
+  shared_parameters_.write(pending_parameters_);
+}
+
+void UnitreeNeuralControl::setContactEstimation(const ContactEstimatorConfig & config)
+{
+  config.validate();
+  pending_filter_config_.contact = config;
+  shared_filter_config_.write(pending_filter_config_);
+  pending_parameters_.contact = config;
+  shared_parameters_.write(pending_parameters_);
+}
+
+void UnitreeNeuralControl::setContactEstimation(
+  int16_t threshold, const ContactEstimatorConfig & config)
+{
+  config.validate();
+  foot_contact_threshold_ = threshold;
+  pending_filter_config_.contact = config;
+  shared_filter_config_.write(pending_filter_config_);
+  pending_parameters_.contact = config;
+  shared_parameters_.write(pending_parameters_);
+}
+
+void UnitreeNeuralControl::setSensorFiltering(bool filtered_inputs, float dq_alpha)
+{
+  auto config = pending_filter_config_;
+  config.dq_alpha = dq_alpha;
+  config.validate();
+  pending_filter_config_ = config;
+  shared_filter_config_.write(pending_filter_config_);
+  pending_parameters_.filtered_inputs = filtered_inputs;
+  shared_parameters_.write(pending_parameters_);
+}
+
+int16_t UnitreeNeuralControl::getFootContactThreshold() const
+{
+  return foot_contact_threshold_;
+}
+
+void UnitreeNeuralControl::setOutputHeads(const std::vector<OutputHeadConfig> & heads)
+{
+  post_processor_ = ActionPostProcessor(heads, nominal_, joint_limits_);
+  output_heads_ = heads;
+  last_action_.assign(post_processor_.actionSize(), 0.0f);
+  chunker_ = ActionChunker(1, last_action_.size(), 1, false, 0.0);
+}
+
+void UnitreeNeuralControl::setJointLimits(const JointLimits & limits)
+{
+  post_processor_ = ActionPostProcessor(output_heads_, nominal_, limits);
+  joint_limits_ = limits;
+}
+
+void UnitreeNeuralControl::setLegMapping(const LegMapping & mapping)
+{
+  leg_mapping_ = mapping;
+}
+
+void UnitreeNeuralControl::setActionChunking(
+  size_t chunk_size, size_t execution_horizon, bool temporal_ensemble,
+  double ensemble_decay)
+{
+  chunker_ = ActionChunker(
+    chunk_size, last_action_.size(), execution_horizon, temporal_ensemble, ensemble_decay);
+}
+
+void UnitreeNeuralControl::setIdleSkipping(
+  bool enabled, double observation_threshold, double goal_threshold,
+  size_t keep_alive_ticks)
+{
+  idle_skipper_ = IdleSkipper(
+    enabled, observation_threshold, goal_threshold, keep_alive_ticks, OBS_GOAL_VELOCITY);
+}
+
+InferenceStats UnitreeNeuralControl::getInferenceStats() const
+{
+  return idle_skipper_.getStats();
+}
+
+void UnitreeNeuralControl::addPolicy(const std::string & name, const std::string & filepath)
+{
+  policy_bank_.add(name, filepath);
+}
+
+bool UnitreeNeuralControl::selectPolicy(const std::string & name)
+{
+  return policy_bank_.select(name);
+}
+
+std::string UnitreeNeuralControl::getActivePolicy() const
+{
+  return policy_bank_.activeName();
+}
+
+std::vector<std::string> UnitreeNeuralControl::getPolicyNames() const
+{
+  return policy_bank_.names();
+}
+
+void UnitreeNeuralControl::setPolicyCrossfade(size_t crossfade_ticks, int cpu)
+{
+  policy_bank_.setCrossfade(crossfade_ticks, cpu);
+}
+
+void UnitreeNeuralControl::setShadowPolicy(
+  const std::string & filepath, int cpu,
+  ShadowCallback callback)
+{
+  shadow_.reset();
+  if (!filepath.empty()) {
+    shadow_ = std::make_unique<ShadowEvaluator>(
+      filepath, OBS_SIZE, last_action_.size(), cpu, std::move(callback));
+  }
+}
+
+ShadowStats UnitreeNeuralControl::getShadowStats() const
+{
+  return shadow_ ? shadow_->getStats() : ShadowStats();
+}
+
+void UnitreeNeuralControl::setEnsemble(
+  const std::vector<std::string> & filepaths, EnsembleMode mode, size_t batched_size,
+  EnsembleReduction reduction, const std::vector<int> & cpus)
+{
+  ensemble_.reset();
+  if (!filepaths.empty()) {
+    ensemble_ = std::make_unique<PolicyEnsemble>(
+      filepaths, last_state_.size(), mode, batched_size, reduction, cpus);
+  }
+}
+
+std::vector<float> UnitreeNeuralControl::getUncertainty() const
+{
+  return ensemble_ ? ensemble_->getSpread() : std::vector<float>();
 }
 
 }  // namespace unitree_a1_neural_control
@@ -14,113 +14,814 @@
 
 #include "unitree_a1_neural_control/unitree_a1_neural_control_node.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include "unitree_a1_neural_control/policy_cache.hpp"
+
 namespace unitree_a1_neural_control
 {
 
-UnitreeNeuralControlNode::UnitreeNeuralControlNode(const rclcpp::NodeOptions & options)
-: Node("unitree_neural_control", options)
-{
-  // Parameters
-  nominal_joint_position_ = {
-    -0.1f, 0.8f, -1.5f, 0.1f, 0.8f, -1.5f,
-    -0.1f, 1.0f, -1.5f, 0.1f, 1.0f, -1.5f};
-  this->declare_parameter(
-    "model_path",
-    std::string("/home/mackop/inttention_ws/policy_network_trained.pt"));
-  std::string model_path;
-  this->get_parameter("model_path", model_path);
-  double kp = this->declare_parameter<double>("kp", 50.0);
-  double kd = this->declare_parameter<double>("kd", 4.0);
-  int16_t foot_contact_threshold = this->declare_parameter<int16_t>("foot_contact_threshold", 20);
-  publish_debug_ = this->declare_parameter<bool>("publish_debug", false);
+namespace
+{
+// Resident set size in kB, 0 when /proc is not available
+long residentMemoryKb()
+{
+  std::ifstream status("/proc/self/status");
+  std::string key;
+  while (status >> key) {
+    if (key == "VmRSS:") {
+      long rss_kb = 0;
+      status >> rss_kb;
+      return rss_kb;
+    }
+    status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  }
+  return 0;
+}
+
+// Parameter names of the legs, in message field order
+const std::array<std::string, Robot::LEG_COUNT> LEG_NAMES = {"FR", "FL", "RR", "RL"};
+
+double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// $ROS_HOME/unitree_a1_neural_control/model_cache, ROS_HOME defaults to ~/.ros
+std::string defaultModelCacheDirectory()
+{
+  const char * ros_home = std::getenv("ROS_HOME");
+  const char * home = std::getenv("HOME");
+  std::string base = ros_home ? ros_home : (home ? std::string(home) + "/.ros" : "/tmp");
+  return base + "/unitree_a1_neural_control/model_cache";
+}
+}  // namespace
+
+template<typename NodeT>
+UnitreeNeuralControlNodeBase<NodeT>::UnitreeNeuralControlNodeBase(
+  const rclcpp::NodeOptions & options)
+: NodeT("unitree_neural_control", options)
+{
+  startup_ = std::chrono::steady_clock::now();
+  nominal_joint_position_ = Robot::NOMINAL;
+  debug_ = false;
+  shadow_enabled_ = false;
+}
+
+template<typename NodeT>
+UnitreeNeuralControlNodeBase<NodeT>::~UnitreeNeuralControlNodeBase()
+{
+  // Join worker threads before the publishers they use are destroyed
+  controller_.reset();
+}
+
+template<typename NodeT>
+template<typename T>
+T UnitreeNeuralControlNodeBase<NodeT>::readParameter(
+  const std::string & name, const T & default_value)
+{
+  if (!this->has_parameter(name)) {
+    parameter_names_.insert(name);
+    return this->template declare_parameter<T>(name, default_value);
+  }
+  return this->get_parameter(name).template get_value<T>();
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::readParameters()
+{
+  auto start = std::chrono::steady_clock::now();
+  params_.model_path = readParameter<std::string>(
+    "model_path", "/home/mackop/inttention_ws/policy_network_trained.pt");
+  params_.kp = readParameter<double>("kp", 50.0);
+  params_.kd = readParameter<double>("kd", 4.0);
+  // Per-joint values in action order (FR, FL, RR, RL x hip, thigh, calf), empty uses kp/kd
+  params_.joint_kp = readParameter<std::vector<double>>(
+    "joint_gains.kp", std::vector<double>{});
+  params_.joint_kd = readParameter<std::vector<double>>(
+    "joint_gains.kd", std::vector<double>{});
+  params_.joint_tau = readParameter<std::vector<double>>(
+    "joint_gains.tau", std::vector<double>{});
+  params_.foot_contact_threshold =
+    readParameter<int16_t>("foot_contact_threshold", 20);
+  // Per-foot contact thresholds in FR, FL, RR, RL order, empty uses foot_contact_threshold
+  params_.contact_thresholds = readParameter<std::vector<double>>(
+    "contact.thresholds", std::vector<double>{});
+  params_.contact_hysteresis =
+    readParameter<double>("contact.hysteresis", 0.0);
+  params_.contact_filter_alpha =
+    readParameter<double>("contact.filter_alpha", 1.0);
+  // Sensor-rate pre-filtering of the policy inputs, off keeps the last-sample inputs
+  params_.sensor_filter_enabled =
+    readParameter<bool>("sensor_filter.enabled", false);
+  params_.sensor_filter_dq_alpha =
+    readParameter<double>("sensor_filter.dq_alpha", 1.0);
+  // Policy output layout, one block of 12 values per head
+  params_.output_heads = readParameter<std::vector<std::string>>(
+    "output_heads.layout", std::vector<std::string>{"position"});
+  params_.output_scale = readParameter<std::vector<double>>(
+    "output_heads.scale", std::vector<double>{0.25});
+  params_.output_min = readParameter<std::vector<double>>(
+    "output_heads.min", std::vector<double>{});
+  params_.output_max = readParameter<std::vector<double>>(
+    "output_heads.max", std::vector<double>{});
+  // Position target bounds in action order, the robot's joint range by default. Empty leaves
+  // the targets unbounded.
+  params_.joint_lower = readParameter<std::vector<double>>(
+    "joint_limits.lower", std::vector<double>(Robot::LOWER.begin(), Robot::LOWER.end()));
+  params_.joint_upper = readParameter<std::vector<double>>(
+    "joint_limits.upper", std::vector<double>(Robot::UPPER.begin(), Robot::UPPER.end()));
+  params_.joint_max_step =
+    readParameter<double>("joint_limits.max_step", 0.0);
+  // Leg order of the policy input and output blocks, e.g. ["FR", "FL", "RR", "RL"]
+  auto legNames = [](const Robot::Legs & order) {
+      std::vector<std::string> names;
+      for (const auto leg : order) {
+        names.push_back(LEG_NAMES[static_cast<size_t>(leg)]);
+      }
+      return names;
+    };
+  params_.joint_leg_order = readParameter<std::vector<std::string>>(
+    "leg_order.joints", legNames(Robot::JOINT_ORDER));
+  params_.contact_leg_order = readParameter<std::vector<std::string>>(
+    "leg_order.contacts", legNames(Robot::CONTACT_ORDER));
+  params_.cycle_leg_order = readParameter<std::vector<std::string>>(
+    "leg_order.cycles", legNames(Robot::CYCLE_ORDER));
+  publish_debug_ = readParameter<bool>("publish_debug", false);
+  params_.chunk_size = readParameter<int64_t>("action_chunk.size", 1);
+  params_.chunk_horizon =
+    readParameter<int64_t>("action_chunk.execution_horizon", 0);
+  params_.chunk_ensemble =
+    readParameter<bool>("action_chunk.temporal_ensemble", false);
+  params_.chunk_decay =
+    readParameter<double>("action_chunk.ensemble_decay", 0.01);
+  // Observation state interpolated to now - delay from the buffered samples
+  interpolate_state_ = readParameter<bool>("state_history.enabled", false);
+  params_.state_history_delay =
+    readParameter<double>("state_history.delay", 0.004);
+  // Receive age in seconds that switches to the hold pose, 0 disables the check
+  params_.state_timeout =
+    readParameter<double>("input_timeout.state", 0.1);
+  params_.cmd_vel_timeout =
+    readParameter<double>("input_timeout.cmd_vel", 0.0);
+  idle_skip_ = readParameter<bool>("idle_skip.enabled", false);
+  params_.idle_obs_threshold =
+    readParameter<double>("idle_skip.observation_threshold", 0.01);
+  params_.idle_goal_threshold =
+    readParameter<double>("idle_skip.goal_threshold", 1e-3);
+  params_.idle_keep_alive =
+    readParameter<int64_t>("idle_skip.keep_alive_ticks", 10);
+  params_.policy_names = readParameter<std::vector<std::string>>(
+    "policy_bank.names", std::vector<std::string>{});
+  params_.policy_paths = readParameter<std::vector<std::string>>(
+    "policy_bank.paths", std::vector<std::string>{});
+  params_.initial_policy =
+    readParameter<std::string>("policy_bank.initial", "default");
+  stand_policy_ = readParameter<std::string>("policy_bank.stand_policy", "");
+  walk_policy_ = readParameter<std::string>("policy_bank.walk_policy", "");
+  params_.crossfade_ticks =
+    readParameter<int64_t>("policy_bank.crossfade_ticks", 0);
+  params_.crossfade_cpu =
+    readParameter<int64_t>("policy_bank.crossfade_cpu", -1);
+  params_.shadow_model_path =
+    readParameter<std::string>("shadow.model_path", "");
+  params_.shadow_cpu = readParameter<int64_t>("shadow.cpu", -1);
+  params_.ensemble_paths = readParameter<std::vector<std::string>>(
+    "ensemble.model_paths", std::vector<std::string>{});
+  params_.ensemble_mode =
+    readParameter<std::string>("ensemble.mode", "parallel");
+  params_.ensemble_size = readParameter<int64_t>("ensemble.size", 0);
+  params_.ensemble_reduction =
+    readParameter<std::string>("ensemble.reduction", "mean");
+  params_.ensemble_cpus = readParameter<std::vector<int64_t>>(
+    "ensemble.cpus", std::vector<int64_t>{});
+  params_.model_cache = readParameter<bool>("model_cache.enabled", true);
+  params_.model_cache_directory =
+    readParameter<std::string>("model_cache.directory", "");
+  if (params_.policy_names.size() != params_.policy_paths.size()) {
+    RCLCPP_ERROR(
+      this->get_logger(), "policy_bank.names and policy_bank.paths differ in size, bank ignored");
+    params_.policy_names.clear();
+    params_.policy_paths.clear();
+  }
+  shadow_enabled_ = !params_.shadow_model_path.empty();
+  startup_times_.parameters_ms = elapsedMs(start);
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::configureController()
+{
+  // Optimized models are cached on disk, keyed by the model hash and runtime version
+  if (params_.model_cache) {
+    auto directory = params_.model_cache_directory.empty() ?
+      defaultModelCacheDirectory() : params_.model_cache_directory;
+    try {
+      setPolicyCacheDirectory(directory);
+    } catch (const std::exception & e) {
+      RCLCPP_WARN(this->get_logger(), "Model cache disabled: %s", e.what());
+    }
+  }
   // Controller
-  RCLCPP_INFO(this->get_logger(), "Loading model: '%s'", model_path.c_str());
+  RCLCPP_INFO(
+    this->get_logger(), "Loading model for %s: '%s'", Robot::NAME, params_.model_path.c_str());
   controller_ = std::make_unique<UnitreeNeuralControl>(
-    model_path,
-    foot_contact_threshold,
+    params_.model_path,
+    params_.foot_contact_threshold,
     nominal_joint_position_);
-  controller_->setGains(kp, kd);
+  this->applyGains();
+  this->applyContactEstimation();
+  this->applySensorFiltering();
+  controller_->setLegMapping(this->legMapping());
+  controller_->setJointLimits(this->jointLimits());
+  controller_->setOutputHeads(this->outputHeads());
+  controller_->setActionChunking(
+    static_cast<size_t>(std::max<int64_t>(params_.chunk_size, 1)),
+    static_cast<size_t>(std::max<int64_t>(params_.chunk_horizon, 0)),
+    params_.chunk_ensemble, params_.chunk_decay);
+  controller_->setIdleSkipping(
+    idle_skip_, params_.idle_obs_threshold, params_.idle_goal_threshold,
+    static_cast<size_t>(std::max<int64_t>(params_.idle_keep_alive, 1)));
+  // Policy bank, every policy is loaded and warmed up before the control loop starts
+  for (size_t i = 0; i < params_.policy_names.size(); i++) {
+    RCLCPP_INFO(
+      this->get_logger(), "Loading policy '%s': '%s'",
+      params_.policy_names[i].c_str(), params_.policy_paths[i].c_str());
+    controller_->addPolicy(params_.policy_names[i], params_.policy_paths[i]);
+  }
+  controller_->setPolicyCrossfade(
+    static_cast<size_t>(std::max<int64_t>(params_.crossfade_ticks, 0)),
+    static_cast<int>(params_.crossfade_cpu));
+  if (!controller_->selectPolicy(params_.initial_policy)) {
+    RCLCPP_WARN(
+      this->get_logger(), "Unknown initial policy '%s'", params_.initial_policy.c_str());
+  }
+  // Ensemble of policy variants, replaces the bank policy when set
+  if (!params_.ensemble_paths.empty()) {
+    RCLCPP_INFO(
+      this->get_logger(), "Loading %s ensemble of %zu model(s)",
+      params_.ensemble_mode.c_str(), params_.ensemble_paths.size());
+    controller_->setEnsemble(
+      params_.ensemble_paths,
+      params_.ensemble_mode == "batched" ? EnsembleMode::BATCHED : EnsembleMode::PARALLEL,
+      static_cast<size_t>(std::max<int64_t>(params_.ensemble_size, 0)),
+      params_.ensemble_reduction == "median" ? EnsembleReduction::MEDIAN : EnsembleReduction::MEAN,
+      std::vector<int>(params_.ensemble_cpus.begin(), params_.ensemble_cpus.end()));
+  }
+  // Shadow policy, evaluated on a low priority thread
+  if (shadow_enabled_) {
+    RCLCPP_INFO(
+      this->get_logger(), "Loading shadow policy: '%s'", params_.shadow_model_path.c_str());
+    controller_->setShadowPolicy(
+      params_.shadow_model_path, static_cast<int>(params_.shadow_cpu),
+      std::bind(&UnitreeNeuralControlNodeBase::publishShadowResult, this, _1));
+  }
+  this->logPolicyLoadStats();
+}
+
+template<typename NodeT>
+template<typename MsgT>
+typename UnitreeNeuralControlNodeBase<NodeT>::template PublisherPtr<MsgT>
+UnitreeNeuralControlNodeBase<NodeT>::createPublisher(
+  const std::string & topic, const rclcpp::QoS & qos)
+{
+  PublisherPtr<MsgT> publisher =
+    this->template create_publisher<MsgT>(topic, qos);
+  publishers_.push_back(publisher);
+  return publisher;
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::createEntities()
+{
+  auto start = std::chrono::steady_clock::now();
   msg_goal_ = std::make_shared<TwistStamped>();
   msg_state_ = std::make_shared<LowState>();
   msg_imu_ = std::make_shared<Imu>();
-  // Subscribers and publishers
+  interpolated_state_ = std::make_shared<LowState>();
+  interpolated_imu_ = std::make_shared<Imu>();
+  // Subscribers
   rmw_qos_profile_t qos_filter = rmw_qos_profile_default;
   qos_filter.depth = 1;
   qos_filter.reliability = RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT;
   qos_filter.durability = RMW_QOS_POLICY_DURABILITY_VOLATILE;
   imu_sub_.reset(new SubscriberImu(this, "~/input/imu", qos_filter));
   state_sub_.reset(new SubscriberLowState(this, "~/input/state", qos_filter));
-  sync_.reset(
-    new Synchronizer(
-      SyncPolicy(2), *imu_sub_, *state_sub_));
-  sync_->registerCallback(&UnitreeNeuralControlNode::imuStateCallback, this);
-  cmd_vel_ = this->create_subscription<TwistStamped>(
-    "~/input/cmd_vel", 1,
-    std::bind(&UnitreeNeuralControlNode::cmdVelCallback, this, _1));
+  // Every message before the synchronizer pairs or drops it
+  imu_sub_->registerCallback(
+    [this](const Imu::ConstSharedPtr & msg) {
+      imu_monitor_.received(
+        this->now().nanoseconds(), rclcpp::Time(msg->header.stamp).nanoseconds());
+    });
+  state_sub_->registerCallback(
+    [this](const LowState::ConstSharedPtr & msg) {
+      state_monitor_.received(
+        this->now().nanoseconds(), rclcpp::Time(msg->header.stamp).nanoseconds());
+    });
+  startup_times_.subscriptions_ms = elapsedMs(start);
+  // Publishers
+  start = std::chrono::steady_clock::now();
   auto qos = rclcpp::QoS(1);
   qos.reliability(RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT);
   qos.durability_volatile();
-  cmd_ = this->create_publisher<LowCmd>("~/output/command", qos);
-  control_loop_ =
-    this->create_wall_timer(
-    std::chrono::milliseconds(20),
-    std::bind(&UnitreeNeuralControlNode::controlLoop, this));
-  // Service
-  reset_ = this->create_service<Trigger>(
-    "~/service/reset",
-    std::bind(
-      &UnitreeNeuralControlNode::resetCallback, this, _1, _2));
-  // Debug
+  cmd_ = createPublisher<LowCmd>("~/output/command", qos);
+  input_health_ = createPublisher<DebugMsg>("~/output/input_health", 1);
+  safe_mode_pub_ = createPublisher<DebugMsg>(
+    "~/output/safe_mode", rclcpp::QoS(1).transient_local());
+  if (!params_.ensemble_paths.empty()) {
+    uncertainty_ = createPublisher<DebugMsg>("~/output/uncertainty", 1);
+  }
+  if (shadow_enabled_) {
+    shadow_action_ = createPublisher<DebugMsg>("~/debug/shadow/action", 1);
+    shadow_divergence_ = createPublisher<DebugMsg>("~/debug/shadow/divergence", 1);
+  }
   if (publish_debug_) {
     debug_ = false;
-    debug_tensor_ = this->create_publisher<DebugMsg>("~/debug/tensor", 1);
-    debug_action_ = this->create_publisher<DebugMsg>("~/debug/action", 1);
-    debug_wrench_ = this->create_publisher<geometry_msgs::msg::WrenchStamped>("~/debug/wrench", 1);
-    debug_foot_contact_fl_ = this->create_publisher<geometry_msgs::msg::WrenchStamped>(
+    debug_tensor_ = createPublisher<DebugMsg>("~/debug/tensor", 1);
+    debug_action_ = createPublisher<DebugMsg>("~/debug/action", 1);
+    debug_wrench_ = createPublisher<geometry_msgs::msg::WrenchStamped>("~/debug/wrench", 1);
+    debug_foot_contact_fl_ = createPublisher<geometry_msgs::msg::WrenchStamped>(
       "~/debug/foot_contact_fl", 1);
-    debug_foot_contact_fr_ = this->create_publisher<geometry_msgs::msg::WrenchStamped>(
+    debug_foot_contact_fr_ = createPublisher<geometry_msgs::msg::WrenchStamped>(
       "~/debug/foot_contact_fr", 1);
-    debug_foot_contact_rl_ = this->create_publisher<geometry_msgs::msg::WrenchStamped>(
+    debug_foot_contact_rl_ = createPublisher<geometry_msgs::msg::WrenchStamped>(
       "~/debug/foot_contact_rl", 1);
-    debug_foot_contact_rr_ = this->create_publisher<geometry_msgs::msg::WrenchStamped>(
+    debug_foot_contact_rr_ = createPublisher<geometry_msgs::msg::WrenchStamped>(
       "~/debug/foot_contact_rr", 1);
   }
+  startup_times_.publishers_ms = elapsedMs(start);
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::createCallbacks()
+{
+  auto start = std::chrono::steady_clock::now();
+  cmd_vel_ = this->template create_subscription<TwistStamped>(
+    "~/input/cmd_vel", 1,
+    std::bind(&UnitreeNeuralControlNodeBase::cmdVelCallback, this, _1));
+  startup_times_.subscriptions_ms += elapsedMs(start);
+  start = std::chrono::steady_clock::now();
+  sync_.reset(
+    new Synchronizer(
+      SyncPolicy(2), *imu_sub_, *state_sub_));
+  sync_->registerCallback(&UnitreeNeuralControlNodeBase::imuStateCallback, this);
+  startup_times_.synchronizer_ms = elapsedMs(start);
+  // Services, one per configured policy
+  start = std::chrono::steady_clock::now();
+  reset_ = this->template create_service<Trigger>(
+    "~/service/reset",
+    std::bind(
+      &UnitreeNeuralControlNodeBase::resetCallback, this, _1, _2));
+  std::vector<std::string> policy_names = {"default"};
+  for (const auto & name : params_.policy_names) {
+    if (std::find(policy_names.begin(), policy_names.end(), name) == policy_names.end()) {
+      policy_names.push_back(name);
+    }
+  }
+  for (const auto & name : policy_names) {
+    select_policy_.push_back(
+      this->template create_service<Trigger>(
+        "~/service/select_policy/" + name,
+        [this, name](const std::shared_ptr<Trigger::Request>/*request*/,
+        std::shared_ptr<Trigger::Response> response) {
+          response->success = controller_->selectPolicy(name);
+          response->message = "Switching to policy '" + name + "'";
+        }));
+  }
+  startup_times_.services_ms = elapsedMs(start);
+  // Gains, contact estimation and sensor filtering are tunable live once the controller
+  // exists, every other parameter of the node is rejected until the next configure
+  parameter_callback_ = this->add_on_set_parameters_callback(
+    std::bind(&UnitreeNeuralControlNodeBase::parametersCallback, this, _1));
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::configureNode()
+{
+  const auto loads_before = getPolicyLoadStats();
+  // Policies load on a separate thread while the ROS entities are created
+  auto controller = std::async(
+    std::launch::async, [this]() {
+      auto start = std::chrono::steady_clock::now();
+      this->configureController();
+      return elapsedMs(start);
+    });
+  this->createEntities();
+  startup_times_.controller_ms = controller.get();
+  this->createCallbacks();
+  const auto loads = getPolicyLoadStats();
+  const double optimize_ms = loads.total_optimize_ms - loads_before.total_optimize_ms;
+  const double warmup_ms = loads.total_warmup_ms - loads_before.total_warmup_ms;
+  const double load_ms = loads.total_load_ms - loads_before.total_load_ms - optimize_ms - warmup_ms;
+  RCLCPP_INFO(
+    this->get_logger(),
+    "Startup phases [ms]: parameters %.1f | policies %.1f (load %.1f, optimize %.1f, "
+    "warm-up %.1f) | subscriptions %.1f, synchronizer %.1f, publishers %.1f, services %.1f",
+    startup_times_.parameters_ms, startup_times_.controller_ms, load_ms, optimize_ms, warmup_ms,
+    startup_times_.subscriptions_ms,
+    startup_times_.synchronizer_ms, startup_times_.publishers_ms, startup_times_.services_ms);
+}
+
+template<typename NodeT>
+rcl_interfaces::msg::SetParametersResult UnitreeNeuralControlNodeBase<NodeT>::parametersCallback(
+  const std::vector<rclcpp::Parameter> & parameters)
+{
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+  // Validate everything first so a rejected set changes nothing
+  for (const auto & parameter : parameters) {
+    const auto & name = parameter.get_name();
+    if (name == "kp" || name == "kd") {
+      const double value = parameter.as_double();
+      if (!std::isfinite(value) || value < 0.0) {
+        result.successful = false;
+        result.reason = name + " has to be a finite, non-negative number";
+      }
+    } else if (name == "joint_gains.kp" || name == "joint_gains.kd" ||
+      name == "joint_gains.tau")
+    {
+      const auto values = parameter.as_double_array();
+      const bool non_negative = name != "joint_gains.tau";
+      bool valid = values.empty() || values.size() == JOINT_COUNT;
+      for (const double value : values) {
+        valid = valid && std::isfinite(value) && (!non_negative || value >= 0.0);
+      }
+      if (!valid) {
+        result.successful = false;
+        result.reason = name + " has to be empty or hold 12 finite values" +
+          (non_negative ? ", none negative" : "");
+      }
+    } else if (name == "foot_contact_threshold") {
+      const int64_t value = parameter.as_int();
+      if (value < 0 || value > std::numeric_limits<int16_t>::max()) {
+        result.successful = false;
+        result.reason = "foot_contact_threshold has to be in [0, 32767]";
+      }
+    } else if (name == "contact.thresholds") {
+      const auto values = parameter.as_double_array();
+      bool valid = values.empty() || values.size() == Robot::LEG_COUNT;
+      for (const double value : values) {
+        valid = valid && std::isfinite(value);
+      }
+      if (!valid) {
+        result.successful = false;
+        result.reason = "contact.thresholds has to be empty or hold 4 finite values";
+      }
+    } else if (name == "contact.hysteresis") {
+      const double value = parameter.as_double();
+      if (!std::isfinite(value) || value < 0.0) {
+        result.successful = false;
+        result.reason = "contact.hysteresis has to be a finite, non-negative number";
+      }
+    } else if (name == "contact.filter_alpha") {
+      const double value = parameter.as_double();
+      if (!(value > 0.0 && value <= 1.0)) {
+        result.successful = false;
+        result.reason = "contact.filter_alpha has to be in (0, 1]";
+      }
+    } else if (name == "sensor_filter.dq_alpha") {
+      const double value = parameter.as_double();
+      if (!(value > 0.0 && value <= 1.0)) {
+        result.successful = false;
+        result.reason = "sensor_filter.dq_alpha has to be in (0, 1]";
+      }
+    } else if (name != "sensor_filter.enabled" && parameter_names_.count(name)) {
+      result.successful = false;
+      result.reason = name + " is only read on configure and cannot change while running";
+    }
+  }
+  if (!result.successful) {
+    return result;
+  }
+  for (const auto & parameter : parameters) {
+    const auto & name = parameter.get_name();
+    if (name == "kp") {
+      params_.kp = parameter.as_double();
+    } else if (name == "kd") {
+      params_.kd = parameter.as_double();
+    } else if (name == "joint_gains.kp") {
+      params_.joint_kp = parameter.as_double_array();
+    } else if (name == "joint_gains.kd") {
+      params_.joint_kd = parameter.as_double_array();
+    } else if (name == "joint_gains.tau") {
+      params_.joint_tau = parameter.as_double_array();
+    } else if (name == "foot_contact_threshold") {
+      params_.foot_contact_threshold = static_cast<int16_t>(parameter.as_int());
+    } else if (name == "contact.thresholds") {
+      params_.contact_thresholds = parameter.as_double_array();
+    } else if (name == "contact.hysteresis") {
+      params_.contact_hysteresis = parameter.as_double();
+    } else if (name == "contact.filter_alpha") {
+      params_.contact_filter_alpha = parameter.as_double();
+    } else if (name == "sensor_filter.enabled") {
+      params_.sensor_filter_enabled = parameter.as_bool();
+    } else if (name == "sensor_filter.dq_alpha") {
+      params_.sensor_filter_dq_alpha = parameter.as_double();
+    } else {
+      continue;
+    }
+    RCLCPP_INFO(this->get_logger(), "Parameter '%s' updated", name.c_str());
+  }
+  this->applyGains();
+  this->applyContactEstimation();
+  this->applySensorFiltering();
+  return result;
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::applyGains()
+{
+  auto toJoints = [](const std::vector<double> & values, double fallback) {
+      JointArray joints;
+      joints.fill(static_cast<float>(fallback));
+      if (values.size() == JOINT_COUNT) {
+        std::copy(values.begin(), values.end(), joints.begin());
+      }
+      return joints;
+    };
+  controller_->setGains(
+    params_.kp, params_.kd, toJoints(params_.joint_kp, params_.kp),
+    toJoints(params_.joint_kd, params_.kd), toJoints(params_.joint_tau, 0.0));
+}
+
+template<typename NodeT>
+std::vector<OutputHeadConfig> UnitreeNeuralControlNodeBase<NodeT>::outputHeads() const
+{
+  const size_t count = params_.output_heads.size();
+  auto sized = [count](const std::vector<double> & values) {
+      return values.empty() || values.size() == count;
+    };
+  if (!sized(params_.output_scale) || !sized(params_.output_min) ||
+    !sized(params_.output_max))
+  {
+    throw std::invalid_argument(
+            "output_heads.scale, min and max have to be empty or match output_heads.layout");
+  }
+  std::vector<OutputHeadConfig> heads;
+  for (size_t i = 0; i < count; i++) {
+    const auto & name = params_.output_heads[i];
+    OutputHeadConfig head;
+    if (name == "position") {
+      head.head = OutputHead::POSITION;
+    } else if (name == "kp") {
+      head.head = OutputHead::KP;
+    } else if (name == "kd") {
+      head.head = OutputHead::KD;
+    } else if (name == "tau") {
+      head.head = OutputHead::TAU;
+    } else {
+      throw std::invalid_argument("Unknown output head '" + name + "'");
+    }
+    head.scale = params_.output_scale.empty() ? 1.0f : static_cast<float>(params_.output_scale[i]);
+    if (!params_.output_min.empty()) {
+      head.min = static_cast<float>(params_.output_min[i]);
+    }
+    if (!params_.output_max.empty()) {
+      head.max = static_cast<float>(params_.output_max[i]);
+    }
+    heads.push_back(head);
+  }
+  return heads;
+}
+
+template<typename NodeT>
+JointLimits UnitreeNeuralControlNodeBase<NodeT>::jointLimits() const
+{
+  auto limits = JointLimits::unlimited();
+  auto toJoints = [](const std::vector<double> & values, JointArray & joints) {
+      if (!values.empty() && values.size() != JOINT_COUNT) {
+        throw std::invalid_argument(
+                "joint_limits.lower and upper have to be empty or hold 12 values");
+      }
+      std::copy(values.begin(), values.end(), joints.begin());
+    };
+  toJoints(params_.joint_lower, limits.lower);
+  toJoints(params_.joint_upper, limits.upper);
+  limits.max_step = static_cast<float>(params_.joint_max_step);
+  return limits;
+}
+
+template<typename NodeT>
+LegMapping UnitreeNeuralControlNodeBase<NodeT>::legMapping() const
+{
+  auto toLegs = [](const std::vector<std::string> & names, const std::string & parameter) {
+      Robot::Legs order;
+      std::array<bool, Robot::LEG_COUNT> seen{};
+      bool valid = names.size() == Robot::LEG_COUNT;
+      for (size_t i = 0; valid && i < names.size(); i++) {
+        const auto name = std::find(LEG_NAMES.begin(), LEG_NAMES.end(), names[i]);
+        const auto leg = static_cast<size_t>(name - LEG_NAMES.begin());
+        valid = name != LEG_NAMES.end() && !seen[leg];
+        if (valid) {
+          seen[leg] = true;
+          order[i] = static_cast<Leg>(leg);
+        }
+      }
+      if (!valid) {
+        throw std::invalid_argument(parameter + " has to list FR, FL, RR and RL once each");
+      }
+      return order;
+    };
+  LegMapping mapping;
+  mapping.joints = jointGather<Robot::JOINTS_PER_LEG>(
+    toLegs(params_.joint_leg_order, "leg_order.joints"));
+  mapping.contacts = legGather(toLegs(params_.contact_leg_order, "leg_order.contacts"));
+  mapping.cycles = legGather(toLegs(params_.cycle_leg_order, "leg_order.cycles"));
+  return mapping;
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::applyContactEstimation()
+{
+  auto config = ContactEstimatorConfig::uniform(params_.foot_contact_threshold);
+  if (params_.contact_thresholds.size() == Robot::LEG_COUNT) {
+    std::copy(
+      params_.contact_thresholds.begin(), params_.contact_thresholds.end(),
+      config.on_threshold.begin());
+  }
+  for (size_t foot = 0; foot < Robot::LEG_COUNT; foot++) {
+    config.off_threshold[foot] =
+      config.on_threshold[foot] - static_cast<float>(params_.contact_hysteresis);
+  }
+  config.alpha = static_cast<float>(params_.contact_filter_alpha);
+  controller_->setContactEstimation(params_.foot_contact_threshold, config);
+}
 
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::applySensorFiltering()
+{
+  controller_->setSensorFiltering(
+    params_.sensor_filter_enabled, static_cast<float>(params_.sensor_filter_dq_alpha));
 }
 
-void UnitreeNeuralControlNode::controlLoop()
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::startControlLoop()
 {
-  // LowState::SharedPtr local_state;
-  // {
-  //   std::lock_guard<std::mutex> lock(state_mutex_);
-  //   local_state = msg_state_;
-  // }
-  auto cmd = controller_->modelForward(msg_goal_, msg_imu_, msg_state_);
+  control_loop_ =
+    this->create_wall_timer(
+    std::chrono::milliseconds(20),
+    std::bind(&UnitreeNeuralControlNodeBase::controlLoop, this));
+  const int64_t now_ns = this->now().nanoseconds();
+  imu_monitor_.reset(now_ns);
+  state_monitor_.reset(now_ns);
+  cmd_vel_monitor_.reset(now_ns);
+  // Every start holds the pose until the first tick sees fresh inputs
+  safe_mode_ = true;
+  RCLCPP_INFO(this->get_logger(), "Holding pose until the inputs are fresh");
+  this->publishSafeMode(
+    now_ns, receiveAgeMs(now_ns, state_receive_ns_), receiveAgeMs(now_ns, cmd_vel_receive_ns_));
+  input_health_timer_ =
+    this->create_wall_timer(
+    std::chrono::seconds(1),
+    std::bind(&UnitreeNeuralControlNodeBase::publishInputHealth, this));
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::stopControlLoop()
+{
+  if (control_loop_) {
+    control_loop_->cancel();
+    control_loop_.reset();
+  }
+  if (input_health_timer_) {
+    input_health_timer_->cancel();
+    input_health_timer_.reset();
+  }
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::destroyEntities()
+{
+  this->stopControlLoop();
+  // Callbacks into the controller go first, then the controller, whose shadow thread
+  // publishes through the node
+  parameter_callback_.reset();
+  sync_.reset();
+  imu_sub_.reset();
+  state_sub_.reset();
+  cmd_vel_.reset();
+  reset_.reset();
+  select_policy_.clear();
+  controller_.reset();
+  publishers_.clear();
+  cmd_.reset();
+  input_health_.reset();
+  safe_mode_pub_.reset();
+  uncertainty_.reset();
+  shadow_action_.reset();
+  shadow_divergence_.reset();
+  debug_tensor_.reset();
+  debug_action_.reset();
+  debug_wrench_.reset();
+  debug_foot_contact_fl_.reset();
+  debug_foot_contact_fr_.reset();
+  debug_foot_contact_rl_.reset();
+  debug_foot_contact_rr_.reset();
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::controlLoop()
+{
+  const auto now = this->now();
+  this->updateSafeMode(now.nanoseconds());
+  if (safe_mode_) {
+    auto cmd = controller_->holdPose();
+    cmd.header.stamp = now;
+    cmd_->publish(cmd);
+    return;
+  }
+  LowState::SharedPtr state = msg_state_;
+  Imu::SharedPtr imu = msg_imu_;
+  StateSample sample;
+  const int64_t target_ns = now.nanoseconds() -
+    static_cast<int64_t>(params_.state_history_delay * 1e9);
+  if (interpolate_state_ && state_history_.sample(target_ns, sample)) {
+    // Fields that are not interpolated come from the latest pair
+    *interpolated_state_ = *msg_state_;
+    *interpolated_imu_ = *msg_imu_;
+    applyStateSample(sample, *interpolated_imu_, *interpolated_state_);
+    state = interpolated_state_;
+    imu = interpolated_imu_;
+  }
+  auto cmd = controller_->modelForward(msg_goal_, imu, state);
   cmd.header.stamp = this->now();
   cmd_->publish(cmd);
+  if (!first_command_) {
+    first_command_ = true;
+    RCLCPP_INFO(this->get_logger(), "First command %.1f ms after startup", elapsedMs(startup_));
+  }
   if(publish_debug_) {
     publishDebugMsg();
   }
+  if (uncertainty_) {
+    auto uncertainty_msg = DebugMsg();
+    uncertainty_msg.header.stamp = cmd.header.stamp;
+    uncertainty_msg.data = controller_->getUncertainty();
+    uncertainty_msg.dim = {1, static_cast<uint8_t>(uncertainty_msg.data.size())};
+    uncertainty_->publish(uncertainty_msg);
+  }
+  if (shadow_enabled_) {
+    auto stats = controller_->getShadowStats();
+    RCLCPP_INFO_THROTTLE(
+      this->get_logger(), *this->get_clock(), 10000,
+      "Shadow: %lu evaluated, %lu dropped, mean L2 divergence %.4f, max divergence %.4f",
+      stats.evaluated, stats.dropped, stats.mean_divergence_l2, stats.max_divergence);
+  }
+  if (idle_skip_) {
+    auto stats = controller_->getInferenceStats();
+    RCLCPP_INFO_THROTTLE(
+      this->get_logger(), *this->get_clock(), 10000,
+      "Idle skip: %lu forwards, %lu skipped, %.3f ms/forward, %.1f ms CPU saved",
+      stats.forwards, stats.skipped, stats.mean_forward_ms, stats.saved_ms);
+  }
 }
 
-void UnitreeNeuralControlNode::imuStateCallback(Imu::SharedPtr imu, LowState::SharedPtr msg)
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::imuStateCallback(
+  Imu::SharedPtr imu, LowState::SharedPtr msg)
 {
   // std::lock_guard<std::mutex> lock(state_mutex_);
   msg_state_ = msg;
   msg_imu_ = imu;
+  state_receive_ns_ = this->now().nanoseconds();
+  imu_monitor_.synchronized();
+  state_monitor_.synchronized();
+  if (interpolate_state_) {
+    state_history_.push(rclcpp::Time(imu->header.stamp).nanoseconds(), *imu, *msg);
+  }
+  // Contacts and filtered inputs see every sample, not only the one the tick reads
+  controller_->updateSensors(*imu, *msg);
 }
 
-void UnitreeNeuralControlNode::cmdVelCallback(TwistStamped::SharedPtr msg)
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::cmdVelCallback(TwistStamped::SharedPtr msg)
 {
   msg_goal_ = msg;
+  cmd_vel_receive_ns_ = this->now().nanoseconds();
+  cmd_vel_monitor_.received(cmd_vel_receive_ns_, rclcpp::Time(msg->header.stamp).nanoseconds());
+  // cmd_vel driven policy selector
+  if (!stand_policy_.empty() && !walk_policy_.empty()) {
+    bool standing = msg->twist.linear.x == 0.0 && msg->twist.linear.y == 0.0 &&
+      msg->twist.angular.z == 0.0;
+    controller_->selectPolicy(standing ? stand_policy_ : walk_policy_);
+  }
 }
 
-void UnitreeNeuralControlNode::resetCallback(
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::resetCallback(
   const std::shared_ptr<Trigger::Request> request,
   std::shared_ptr<Trigger::Response> response)
 {
   (void) request; // unused
   controller_->resetController();
+  this->logPolicyLoadStats();
   response->success = true;
   if (publish_debug_) {
     debug_ = true;
@@ -128,7 +829,93 @@ void UnitreeNeuralControlNode::resetCallback(
 
 }
 
-void UnitreeNeuralControlNode::publishDebugMsg()
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::logPolicyLoadStats()
+{
+  auto stats = getPolicyLoadStats();
+  RCLCPP_INFO(
+    this->get_logger(),
+    "Policy loads: %lu, last %.1f ms, total %.1f ms, model cache %lu hit(s) %lu miss(es)",
+    stats.loads, stats.last_load_ms, stats.total_load_ms, stats.cache_hits, stats.cache_misses);
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::publishShadowResult(const ShadowResult & result)
+{
+  // Called from the shadow thread
+  auto timestamp = this->now();
+  auto action_msg = DebugMsg();
+  action_msg.header.stamp = timestamp;
+  action_msg.dim = {1, static_cast<uint8_t>(result.shadow_action.size())};
+  action_msg.data = result.shadow_action;
+  shadow_action_->publish(action_msg);
+  auto divergence_msg = DebugMsg();
+  divergence_msg.header.stamp = timestamp;
+  divergence_msg.dim = {1, 2};
+  divergence_msg.data = {
+    static_cast<float>(result.divergence_l2), static_cast<float>(result.divergence_max)};
+  shadow_divergence_->publish(divergence_msg);
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::updateSafeMode(int64_t now_ns)
+{
+  const double state_age = receiveAgeMs(now_ns, state_receive_ns_);
+  const double cmd_vel_age = receiveAgeMs(now_ns, cmd_vel_receive_ns_);
+  const bool stale =
+    inputsStale(state_age, cmd_vel_age, params_.state_timeout, params_.cmd_vel_timeout);
+  if (stale == safe_mode_) {
+    return;
+  }
+  safe_mode_ = stale;
+  safe_mode_transitions_++;
+  if (safe_mode_) {
+    RCLCPP_WARN(
+      this->get_logger(), "Stale inputs (state %.1f ms, cmd_vel %.1f ms old), holding pose",
+      state_age, cmd_vel_age);
+  } else {
+    RCLCPP_INFO(
+      this->get_logger(), "Inputs fresh (state %.1f ms, cmd_vel %.1f ms old), running policy",
+      state_age, cmd_vel_age);
+  }
+  this->publishSafeMode(now_ns, state_age, cmd_vel_age);
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::publishSafeMode(
+  int64_t now_ns, double state_age, double cmd_vel_age)
+{
+  // Latched, late subscribers see the current mode
+  auto safe_mode_msg = DebugMsg();
+  safe_mode_msg.header.stamp = rclcpp::Time(now_ns);
+  safe_mode_msg.dim = {1, 4};
+  safe_mode_msg.data = {
+    safe_mode_ ? 1.0f : 0.0f, static_cast<float>(safe_mode_transitions_),
+    static_cast<float>(state_age), static_cast<float>(cmd_vel_age)};
+  safe_mode_pub_->publish(safe_mode_msg);
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::publishInputHealth()
+{
+  const auto timestamp = this->now();
+  auto health_msg = DebugMsg();
+  health_msg.header.stamp = timestamp;
+  health_msg.dim = {3, static_cast<uint8_t>(InputHealth::FIELD_COUNT)};
+  for (auto * monitor : {&imu_monitor_, &state_monitor_, &cmd_vel_monitor_}) {
+    const auto health = monitor->report(timestamp.nanoseconds());
+    health_msg.data.insert(
+      health_msg.data.end(), {
+        static_cast<float>(health.rate_hz), static_cast<float>(health.jitter_ms),
+        static_cast<float>(health.max_gap_ms), static_cast<float>(health.mean_delay_ms),
+        static_cast<float>(health.max_delay_ms), static_cast<float>(health.received),
+        static_cast<float>(health.dropped)});
+  }
+  input_health_->publish(health_msg);
+}
+
+template<typename NodeT>
+void UnitreeNeuralControlNodeBase<NodeT>::publishDebugMsg()
 {
   auto timestamp = this->now();
   std::vector<float> input, output;
@@ -167,9 +954,97 @@ void UnitreeNeuralControlNode::publishDebugMsg()
   debug_wrench_->publish(wrench_msg);
 }
 
+template class UnitreeNeuralControlNodeBase<rclcpp::Node>;
+template class UnitreeNeuralControlNodeBase<rclcpp_lifecycle::LifecycleNode>;
+
+UnitreeNeuralControlNode::UnitreeNeuralControlNode(const rclcpp::NodeOptions & options)
+: UnitreeNeuralControlNodeBase(options)
+{
+  this->readParameters();
+  this->configureNode();
+  this->startControlLoop();
+  RCLCPP_INFO(
+    this->get_logger(), "Started in %.1f ms, resident memory %ld kB", elapsedMs(startup_),
+    residentMemoryKb());
+}
+
+UnitreeNeuralControlLifecycleNode::UnitreeNeuralControlLifecycleNode(
+  const rclcpp::NodeOptions & options)
+: UnitreeNeuralControlNodeBase(options)
+{
+  // Declared here so they can be set before on_configure, which reads them again
+  this->readParameters();
+}
+
+UnitreeNeuralControlLifecycleNode::CallbackReturn UnitreeNeuralControlLifecycleNode::on_configure(
+  const rclcpp_lifecycle::State & /*state*/)
+{
+  auto start = std::chrono::steady_clock::now();
+  try {
+    this->readParameters();
+    this->configureNode();
+  } catch (const std::exception & e) {
+    RCLCPP_ERROR(this->get_logger(), "Configuration failed: %s", e.what());
+    this->destroyEntities();
+    return CallbackReturn::FAILURE;
+  }
+  RCLCPP_INFO(
+    this->get_logger(), "Configured in %.1f ms, resident memory %ld kB", elapsedMs(start),
+    residentMemoryKb());
+  return CallbackReturn::SUCCESS;
+}
+
+UnitreeNeuralControlLifecycleNode::CallbackReturn UnitreeNeuralControlLifecycleNode::on_activate(
+  const rclcpp_lifecycle::State & /*state*/)
+{
+  startup_ = std::chrono::steady_clock::now();
+  first_command_ = false;
+  this->setPublishersActive(true);
+  this->startControlLoop();
+  return CallbackReturn::SUCCESS;
+}
+
+UnitreeNeuralControlLifecycleNode::CallbackReturn UnitreeNeuralControlLifecycleNode::on_deactivate(
+  const rclcpp_lifecycle::State & /*state*/)
+{
+  this->stopControlLoop();
+  this->setPublishersActive(false);
+  return CallbackReturn::SUCCESS;
+}
+
+UnitreeNeuralControlLifecycleNode::CallbackReturn UnitreeNeuralControlLifecycleNode::on_cleanup(
+  const rclcpp_lifecycle::State & /*state*/)
+{
+  this->destroyEntities();
+  return CallbackReturn::SUCCESS;
+}
+
+UnitreeNeuralControlLifecycleNode::CallbackReturn UnitreeNeuralControlLifecycleNode::on_shutdown(
+  const rclcpp_lifecycle::State & /*state*/)
+{
+  this->destroyEntities();
+  return CallbackReturn::SUCCESS;
+}
+
+void UnitreeNeuralControlLifecycleNode::setPublishersActive(bool active)
+{
+  for (const auto & publisher : publishers_) {
+    auto lifecycle_publisher =
+      std::dynamic_pointer_cast<rclcpp_lifecycle::LifecyclePublisherInterface>(publisher);
+    if (!lifecycle_publisher) {
+      continue;
+    }
+    if (active) {
+      lifecycle_publisher->on_activate();
+    } else {
+      lifecycle_publisher->on_deactivate();
+    }
+  }
+}
 
 }  // namespace unitree_a1_neural_control
 
 #include "rclcpp_components/register_node_macro.hpp"
 
 RCLCPP_COMPONENTS_REGISTER_NODE(unitree_a1_neural_control::UnitreeNeuralControlNode)
+RCLCPP_COMPONENTS_REGISTER_NODE(unitree_a1_neural_control::UnitreeNeuralControlLifecycleNode)
@@ -0,0 +1,61 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UNITREE_A1_NEURAL_CONTROL__TEST__POLICY_FIXTURES_HPP_
+#define UNITREE_A1_NEURAL_CONTROL__TEST__POLICY_FIXTURES_HPP_
+
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "unitree_a1_neural_control/native_policy_backend.hpp"
+#include "unitree_a1_neural_control/unitree_a1_neural_control.hpp"
+
+namespace unitree_a1_neural_control
+{
+
+// Single linear layer with zero weights, every output equals `bias`
+inline std::string writeConstantPolicy(const std::string & name, float bias)
+{
+  const std::string path = "/tmp/" + name + "_" + std::to_string(::getpid()) + ".npw";
+  NativeWeightsHeader header{};
+  std::memcpy(header.magic, NATIVE_WEIGHTS_MAGIC, sizeof(header.magic));
+  header.version = NATIVE_WEIGHTS_VERSION;
+  header.layer_count = 1;
+  header.observation_size = OBS_SIZE;
+  header.action_size = JOINT_COUNT;
+  auto align = [](size_t offset) {
+      return (offset + NATIVE_WEIGHTS_ALIGNMENT - 1) / NATIVE_WEIGHTS_ALIGNMENT *
+             NATIVE_WEIGHTS_ALIGNMENT;
+    };
+  NativeLayerHeader layer{};
+  layer.out_features = JOINT_COUNT;
+  layer.in_features = OBS_SIZE;
+  layer.weight_offset = align(sizeof(header) + sizeof(layer));
+  layer.bias_offset = align(layer.weight_offset + JOINT_COUNT * OBS_SIZE * sizeof(float));
+  std::vector<char> data(layer.bias_offset + JOINT_COUNT * sizeof(float), 0);
+  std::memcpy(data.data(), &header, sizeof(header));
+  std::memcpy(data.data() + sizeof(header), &layer, sizeof(layer));
+  std::vector<float> biases(JOINT_COUNT, bias);
+  std::memcpy(data.data() + layer.bias_offset, biases.data(), biases.size() * sizeof(float));
+  std::ofstream(path, std::ios::binary).write(
+    data.data(), static_cast<std::streamsize>(data.size()));
+  return path;
+}
+
+}  // namespace unitree_a1_neural_control
+
+#endif  // UNITREE_A1_NEURAL_CONTROL__TEST__POLICY_FIXTURES_HPP_
@@ -0,0 +1,137 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "unitree_a1_neural_control/action_post_processor.hpp"
+
+namespace
+{
+using unitree_a1_neural_control::JOINT_COUNT;
+using unitree_a1_neural_control::JointArray;
+
+JointArray filled(float value)
+{
+  JointArray joints;
+  joints.fill(value);
+  return joints;
+}
+}  // namespace
+
+TEST(ActionPostProcessor, NonFiniteValuesHoldThePreviousOutput)
+{
+  using namespace unitree_a1_neural_control;
+  ActionPostProcessor processor({{OutputHead::POSITION, 1.0f}}, filled(0.2f));
+  std::vector<float> raw(JOINT_COUNT, std::numeric_limits<float>::quiet_NaN());
+  // Nothing to hold before the first tick but the nominal pose
+  processor.process(raw.data());
+  for (size_t i = 0; i < JOINT_COUNT; i++) {
+    EXPECT_FLOAT_EQ(processor.output(OutputHead::POSITION)[i], 0.2f);
+  }
+  raw.assign(JOINT_COUNT, 0.5f);
+  processor.process(raw.data());
+  raw[0] = std::numeric_limits<float>::quiet_NaN();
+  raw[1] = std::numeric_limits<float>::infinity();
+  raw[2] = -std::numeric_limits<float>::infinity();
+  raw[3] = 0.1f;
+  processor.process(raw.data());
+  const float * position = processor.output(OutputHead::POSITION);
+  EXPECT_FLOAT_EQ(position[0], 0.7f);
+  EXPECT_FLOAT_EQ(position[1], 0.7f);
+  EXPECT_FLOAT_EQ(position[2], 0.7f);
+  EXPECT_FLOAT_EQ(position[3], 0.3f);
+}
+
+TEST(ActionPostProcessor, ClampsPositionsToJointLimits)
+{
+  using namespace unitree_a1_neural_control;
+  JointLimits limits;
+  limits.lower = filled(-0.5f);
+  limits.upper = filled(0.5f);
+  // The tighter of the head range and the joint limits wins
+  ActionPostProcessor processor(
+    {{OutputHead::POSITION, 1.0f, -1.0f, 0.25f}}, filled(0.0f), limits);
+  std::vector<float> raw(JOINT_COUNT, 2.0f);
+  raw[0] = -2.0f;
+  raw[1] = 0.1f;
+  processor.process(raw.data());
+  const float * position = processor.output(OutputHead::POSITION);
+  EXPECT_FLOAT_EQ(position[0], -0.5f);
+  EXPECT_FLOAT_EQ(position[1], 0.1f);
+  EXPECT_FLOAT_EQ(position[2], 0.25f);
+  limits.lower = filled(1.0f);
+  limits.upper = filled(2.0f);
+  EXPECT_THROW(
+    ActionPostProcessor({{OutputHead::POSITION, 1.0f, -1.0f, 0.5f}}, filled(0.0f), limits),
+    std::invalid_argument);
+}
+
+TEST(ActionPostProcessor, RateLimitsFromTheNominalPose)
+{
+  using namespace unitree_a1_neural_control;
+  JointLimits limits = JointLimits::unlimited();
+  limits.max_step = 0.1f;
+  ActionPostProcessor processor({{OutputHead::POSITION, 1.0f}}, filled(0.3f), limits);
+  const std::vector<float> raw(JOINT_COUNT, 1.0f);
+  // The first tick already steps from the nominal pose
+  for (float expected : {0.4f, 0.5f, 0.6f}) {
+    processor.process(raw.data());
+    EXPECT_FLOAT_EQ(processor.output(OutputHead::POSITION)[0], expected);
+  }
+  processor.reset();
+  EXPECT_FLOAT_EQ(processor.output(OutputHead::POSITION)[0], 0.3f);
+  processor.process(raw.data());
+  EXPECT_FLOAT_EQ(processor.output(OutputHead::POSITION)[0], 0.4f);
+  limits.max_step = -0.1f;
+  EXPECT_THROW(
+    ActionPostProcessor({{OutputHead::POSITION, 1.0f}}, filled(0.3f), limits),
+    std::invalid_argument);
+}
+
+TEST(ActionPostProcessor, BoundsGainAndTorqueHeads)
+{
+  using namespace unitree_a1_neural_control;
+  ActionPostProcessor processor(
+    {{OutputHead::POSITION, 1.0f}, {OutputHead::KP, 1.0f}, {OutputHead::KD, 1.0f},
+      {OutputHead::TAU, 1.0f}}, filled(0.0f));
+  ASSERT_EQ(processor.actionSize(), 4 * JOINT_COUNT);
+  // Zero gains and torque until the first tick
+  EXPECT_FLOAT_EQ(processor.output(OutputHead::KP)[0], 0.0f);
+  EXPECT_FLOAT_EQ(processor.output(OutputHead::TAU)[0], 0.0f);
+  std::vector<float> raw(processor.actionSize(), 0.0f);
+  raw[processor.offset(OutputHead::KP) + 0] = 1e3f;
+  raw[processor.offset(OutputHead::KP) + 1] = -5.0f;
+  raw[processor.offset(OutputHead::KP) + 2] = 30.0f;
+  raw[processor.offset(OutputHead::KD) + 0] = 50.0f;
+  raw[processor.offset(OutputHead::KD) + 1] = -1.0f;
+  raw[processor.offset(OutputHead::TAU) + 0] = 1e3f;
+  raw[processor.offset(OutputHead::TAU) + 1] = -1e3f;
+  processor.process(raw.data());
+  EXPECT_FLOAT_EQ(processor.output(OutputHead::KP)[0], MAX_HEAD_KP);
+  EXPECT_FLOAT_EQ(processor.output(OutputHead::KP)[1], 0.0f);
+  EXPECT_FLOAT_EQ(processor.output(OutputHead::KP)[2], 30.0f);
+  EXPECT_FLOAT_EQ(processor.output(OutputHead::KD)[0], MAX_HEAD_KD);
+  EXPECT_FLOAT_EQ(processor.output(OutputHead::KD)[1], 0.0f);
+  EXPECT_FLOAT_EQ(processor.output(OutputHead::TAU)[0], Robot::MAX_TORQUE);
+  EXPECT_FLOAT_EQ(processor.output(OutputHead::TAU)[1], -Robot::MAX_TORQUE);
+  // A configured range entirely outside the safe one is rejected
+  EXPECT_THROW(
+    ActionPostProcessor(
+      {{OutputHead::POSITION, 1.0f}, {OutputHead::KP, 1.0f, -10.0f, -1.0f}}, filled(0.0f)),
+    std::invalid_argument);
+}
@@ -0,0 +1,96 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include "unitree_a1_neural_control/contact_estimator.hpp"
+
+namespace
+{
+using unitree_a1_neural_control::FootArray;
+
+FootArray forces(float value)
+{
+  FootArray force;
+  force.fill(value);
+  return force;
+}
+}  // namespace
+
+TEST(ContactEstimator, SchmittTriggerHoldsContactBetweenThresholds)
+{
+  using namespace unitree_a1_neural_control;
+  ContactEstimatorConfig config = ContactEstimatorConfig::uniform(30.0f);
+  config.off_threshold.fill(10.0f);
+  ContactEstimator estimator(config);
+  // Force below the on threshold does not enter contact, once in contact the foot stays
+  // there until the force drops below the off threshold
+  const float sequence[] = {20.0f, 35.0f, 20.0f, 10.0f, 5.0f, 20.0f, 30.0f};
+  const float expected[] = {0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f};
+  for (size_t i = 0; i < sizeof(sequence) / sizeof(sequence[0]); i++) {
+    estimator.update(forces(sequence[i]));
+    for (size_t foot = 0; foot < Robot::LEG_COUNT; foot++) {
+      EXPECT_EQ(estimator.contact()[foot], expected[i]) << "sample " << i << " foot " << foot;
+    }
+  }
+  estimator.reset();
+  EXPECT_EQ(estimator.contact()[0], 0.0f);
+  EXPECT_EQ(estimator.filtered()[0], 0.0f);
+}
+
+TEST(ContactEstimator, FeetAreIndependent)
+{
+  using namespace unitree_a1_neural_control;
+  ContactEstimatorConfig config = ContactEstimatorConfig::uniform(20.0f);
+  config.on_threshold = {20.0f, 40.0f, 20.0f, 20.0f};
+  config.off_threshold = {20.0f, 10.0f, 20.0f, 20.0f};
+  ContactEstimator estimator(config);
+  estimator.update({25.0f, 45.0f, 0.0f, 100.0f});
+  EXPECT_EQ(estimator.contact(), (FootArray{1.0f, 1.0f, 0.0f, 1.0f}));
+  estimator.update({15.0f, 15.0f, 25.0f, 0.0f});
+  EXPECT_EQ(estimator.contact(), (FootArray{0.0f, 1.0f, 1.0f, 0.0f}));
+}
+
+TEST(ContactEstimator, FilterDelaysContact)
+{
+  using namespace unitree_a1_neural_control;
+  ContactEstimatorConfig config = ContactEstimatorConfig::uniform(20.0f);
+  config.alpha = 0.5f;
+  ContactEstimator estimator(config);
+  estimator.update(forces(30.0f));
+  EXPECT_FLOAT_EQ(estimator.filtered()[0], 15.0f);
+  EXPECT_EQ(estimator.contact()[0], 0.0f);
+  estimator.update(forces(30.0f));
+  EXPECT_FLOAT_EQ(estimator.filtered()[0], 22.5f);
+  EXPECT_EQ(estimator.contact()[0], 1.0f);
+  // A single spike is smoothed out
+  estimator.reset();
+  estimator.update(forces(38.0f));
+  estimator.update(forces(0.0f));
+  EXPECT_EQ(estimator.contact()[0], 0.0f);
+}
+
+TEST(ContactEstimator, RejectsInvalidConfig)
+{
+  using namespace unitree_a1_neural_control;
+  ContactEstimatorConfig config = ContactEstimatorConfig::uniform(20.0f);
+  config.off_threshold[2] = 25.0f;
+  EXPECT_THROW(ContactEstimator{config}, std::invalid_argument);
+  config = ContactEstimatorConfig::uniform(20.0f);
+  config.alpha = 0.0f;
+  EXPECT_THROW(ContactEstimator{config}, std::invalid_argument);
+  config.alpha = 1.5f;
+  EXPECT_THROW(ContactEstimator{config}, std::invalid_argument);
+}
@@ -0,0 +1,85 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "policy_fixtures.hpp"
+
+namespace
+{
+using unitree_a1_neural_control::NativeLayerHeader;
+using unitree_a1_neural_control::NativeWeightsHeader;
+
+// Valid constant policy with the first layer entry patched by `patch`
+template<typename Patch>
+std::string writePatchedPolicy(const std::string & name, Patch patch)
+{
+  const auto path = unitree_a1_neural_control::writeConstantPolicy(name, 0.5f);
+  std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+  NativeLayerHeader layer;
+  file.seekg(sizeof(NativeWeightsHeader));
+  file.read(reinterpret_cast<char *>(&layer), sizeof(layer));
+  patch(layer);
+  file.seekp(sizeof(NativeWeightsHeader));
+  file.write(reinterpret_cast<const char *>(&layer), sizeof(layer));
+  return path;
+}
+}  // namespace
+
+TEST(NativePolicyBackend, EvaluatesConstantPolicy)
+{
+  using namespace unitree_a1_neural_control;
+  const auto path = writeConstantPolicy("native_test_valid", 0.5f);
+  NativePolicyBackend backend(path, OBS_SIZE);
+  std::vector<float> observation(OBS_SIZE, 1.0f);
+  std::vector<float> action(JOINT_COUNT, 0.0f);
+  backend.forward(observation.data(), action.data());
+  for (const float value : action) {
+    EXPECT_FLOAT_EQ(value, 0.5f);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(NativePolicyBackend, RejectsUnknownActivation)
+{
+  using namespace unitree_a1_neural_control;
+  const auto path = writePatchedPolicy(
+    "native_test_activation", [](NativeLayerHeader & layer) {layer.activation = 7;});
+  EXPECT_THROW(NativePolicyBackend(path, OBS_SIZE), std::runtime_error);
+  std::remove(path.c_str());
+}
+
+// Offsets and sizes that wrap around when added or multiplied
+TEST(NativePolicyBackend, RejectsWrappingLayerTable)
+{
+  using namespace unitree_a1_neural_control;
+  const auto offset = writePatchedPolicy(
+    "native_test_offset", [](NativeLayerHeader & layer) {
+      layer.weight_offset = ~uint64_t{0} - (NATIVE_WEIGHTS_ALIGNMENT - 1);
+    });
+  EXPECT_THROW(NativePolicyBackend(offset, OBS_SIZE), std::runtime_error);
+  std::remove(offset.c_str());
+  const auto bias = writePatchedPolicy(
+    "native_test_bias", [](NativeLayerHeader & layer) {
+      layer.bias_offset = ~uint64_t{0} - (NATIVE_WEIGHTS_ALIGNMENT - 1);
+    });
+  EXPECT_THROW(NativePolicyBackend(bias, OBS_SIZE), std::runtime_error);
+  std::remove(bias.c_str());
+}
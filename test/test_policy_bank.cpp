@@ -0,0 +1,57 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "policy_fixtures.hpp"
+#include "unitree_a1_neural_control/policy_bank.hpp"
+
+// A selection during a crossfade must not restart the blend from the outgoing policy
+TEST(PolicyBank, SelectionDuringCrossfadeWaitsForTheFade)
+{
+  using namespace unitree_a1_neural_control;
+  const std::vector<std::string> paths = {
+    writeConstantPolicy("bank_test_a", 0.0f),
+    writeConstantPolicy("bank_test_b", 1.0f),
+    writeConstantPolicy("bank_test_c", 2.0f)};
+  PolicyBank bank(OBS_SIZE);
+  bank.add("a", paths[0]);
+  bank.add("b", paths[1]);
+  bank.add("c", paths[2]);
+  bank.setCrossfade(3, -1);
+  const std::vector<float> state(OBS_SIZE, 0.0f);
+  EXPECT_FLOAT_EQ(bank.forward(state)[0], 0.0f);
+  ASSERT_TRUE(bank.select("b"));
+  EXPECT_TRUE(bank.applySelection());
+  float last = bank.forward(state)[0];
+  EXPECT_FLOAT_EQ(last, 0.25f);
+  ASSERT_TRUE(bank.select("c"));
+  std::vector<float> outputs;
+  for (int tick = 0; tick < 8; tick++) {
+    bank.applySelection();
+    outputs.push_back(bank.forward(state)[0]);
+  }
+  // a -> b finishes, then b -> c starts, every step is a quarter of the gap
+  const std::vector<float> expected = {0.5f, 0.75f, 1.25f, 1.5f, 1.75f, 2.0f, 2.0f, 2.0f};
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_FLOAT_EQ(outputs[i], expected[i]) << "tick " << i;
+  }
+  EXPECT_EQ(bank.activeName(), "c");
+  for (const auto & path : paths) {
+    std::remove(path.c_str());
+  }
+}
@@ -0,0 +1,84 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include "policy_fixtures.hpp"
+#include "unitree_a1_neural_control/input_monitor.hpp"
+
+namespace
+{
+std::array<float, unitree_a1_neural_control::JOINT_COUNT> positions(
+  unitree_a1_legged_msgs::msg::LowCmd cmd)
+{
+  std::array<float, unitree_a1_neural_control::JOINT_COUNT> q;
+  const auto motors = unitree_a1_neural_control::motorCmdTable(cmd);
+  for (size_t i = 0; i < q.size(); i++) {
+    q[i] = motors[i]->q;
+  }
+  return q;
+}
+}  // namespace
+
+TEST(SafeMode, EntersOnStaleOrMissingInputs)
+{
+  using namespace unitree_a1_neural_control;
+  const int64_t now_ns = 10'000'000'000;
+  // Nothing received yet
+  EXPECT_TRUE(std::isinf(receiveAgeMs(now_ns, 0)));
+  EXPECT_TRUE(inputsStale(receiveAgeMs(now_ns, 0), 0.0, 0.1, 0.5));
+  EXPECT_DOUBLE_EQ(receiveAgeMs(now_ns, now_ns - 20'000'000), 20.0);
+  // Fresh inputs run the policy, either stream past its timeout holds the pose
+  EXPECT_FALSE(inputsStale(50.0, 400.0, 0.1, 0.5));
+  EXPECT_TRUE(inputsStale(150.0, 400.0, 0.1, 0.5));
+  EXPECT_TRUE(inputsStale(50.0, 600.0, 0.1, 0.5));
+  // A timeout of 0 disables its check
+  EXPECT_FALSE(inputsStale(std::numeric_limits<double>::infinity(), 50.0, 0.0, 0.5));
+  EXPECT_FALSE(inputsStale(50.0, std::numeric_limits<double>::infinity(), 0.1, 0.0));
+}
+
+// The held pose is the last commanded position, and the policy output after the hold is rate
+// limited from it like any other tick
+TEST(SafeMode, ExitIsRateLimitedFromTheHeldPose)
+{
+  using namespace unitree_a1_neural_control;
+  constexpr float MAX_STEP = 0.05f;
+  const auto policy = writeConstantPolicy("safe_mode_test_policy", 1.0f);
+  UnitreeNeuralControl controller(policy, 20, Robot::NOMINAL);
+  JointLimits limits = JointLimits::unlimited();
+  limits.max_step = MAX_STEP;
+  controller.setJointLimits(limits);
+  auto goal = std::make_shared<geometry_msgs::msg::TwistStamped>();
+  auto state = std::make_shared<unitree_a1_legged_msgs::msg::LowState>();
+  state->imu.orientation.w = 1.0;
+  // Started in safe mode, the nominal pose is held
+  auto held = positions(controller.holdPose());
+  for (int tick = 0; tick < 3; tick++) {
+    const auto commanded = positions(controller.modelForward(goal, state));
+    for (size_t i = 0; i < JOINT_COUNT; i++) {
+      EXPECT_NEAR(std::fabs(commanded[i] - held[i]), MAX_STEP, 1e-5f) << "joint " << i;
+    }
+    // Inputs went stale, the pose the policy reached is held
+    const auto hold = positions(controller.holdPose());
+    EXPECT_EQ(hold, commanded);
+    EXPECT_EQ(positions(controller.holdPose()), commanded);
+    held = hold;
+  }
+  std::remove(policy.c_str());
+}
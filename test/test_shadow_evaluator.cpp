@@ -0,0 +1,47 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include "policy_fixtures.hpp"
+
+// The shadow policy has to see the observation msgToTensor actually builds
+TEST(ShadowEvaluator, EvaluatesControllerObservations)
+{
+  using namespace unitree_a1_neural_control;
+  const auto active = writeConstantPolicy("shadow_test_active", 0.0f);
+  const auto candidate = writeConstantPolicy("shadow_test_candidate", 0.1f);
+  UnitreeNeuralControl controller(active, 20, Robot::NOMINAL);
+  controller.setShadowPolicy(candidate, -1, nullptr);
+  auto goal = std::make_shared<geometry_msgs::msg::TwistStamped>();
+  auto imu = std::make_shared<sensor_msgs::msg::Imu>();
+  imu->orientation.w = 1.0;
+  auto state = std::make_shared<unitree_a1_legged_msgs::msg::LowState>();
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (controller.getShadowStats().evaluated < 3 &&
+    std::chrono::steady_clock::now() < deadline)
+  {
+    controller.modelForward(goal, imu, state);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  const auto stats = controller.getShadowStats();
+  EXPECT_GE(stats.evaluated, 3u);
+  EXPECT_NEAR(stats.max_divergence, 0.1, 1e-6);
+  std::remove(active.c_str());
+  std::remove(candidate.c_str());
+}
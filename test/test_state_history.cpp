@@ -0,0 +1,131 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include "unitree_a1_neural_control/sensor_pre_filter.hpp"
+#include "unitree_a1_neural_control/state_history.hpp"
+
+namespace
+{
+// Every interpolated field set to `value`
+void pushSample(
+  unitree_a1_neural_control::StateHistory & history, int64_t stamp_ns, double value)
+{
+  using namespace unitree_a1_neural_control;
+  sensor_msgs::msg::Imu imu;
+  imu.angular_velocity.x = value;
+  imu.linear_acceleration.z = value;
+  imu.orientation.w = 1.0;
+  unitree_a1_legged_msgs::msg::LowState state;
+  for (auto * motor : motorStateTable(state.motor_state)) {
+    motor->q = value;
+    motor->dq = value;
+    motor->tau_est = value;
+  }
+  history.push(stamp_ns, imu, state);
+}
+}  // namespace
+
+TEST(StateHistory, EmptyHistoryHasNoSample)
+{
+  using namespace unitree_a1_neural_control;
+  StateHistory history;
+  StateSample sample;
+  EXPECT_FALSE(history.sample(0, sample));
+  EXPECT_EQ(history.size(), 0u);
+}
+
+TEST(StateHistory, InterpolatesBetweenNeighbours)
+{
+  using namespace unitree_a1_neural_control;
+  StateHistory history;
+  pushSample(history, 1000, 0.0);
+  pushSample(history, 2000, 1.0);
+  pushSample(history, 4000, 3.0);
+  StateSample sample;
+  ASSERT_TRUE(history.sample(1500, sample));
+  EXPECT_EQ(sample.stamp_ns, 1500);
+  EXPECT_FLOAT_EQ(sample.q[0], 0.5f);
+  EXPECT_FLOAT_EQ(sample.dq[JOINT_COUNT - 1], 0.5f);
+  EXPECT_DOUBLE_EQ(sample.angular_velocity[0], 0.5);
+  EXPECT_DOUBLE_EQ(sample.linear_acceleration[2], 0.5);
+  EXPECT_DOUBLE_EQ(sample.orientation[3], 1.0);
+  ASSERT_TRUE(history.sample(3000, sample));
+  EXPECT_FLOAT_EQ(sample.tau_est[3], 2.0f);
+  ASSERT_TRUE(history.sample(2000, sample));
+  EXPECT_FLOAT_EQ(sample.q[0], 1.0f);
+}
+
+TEST(StateHistory, HoldsTheEndsOfTheBufferedRange)
+{
+  using namespace unitree_a1_neural_control;
+  StateHistory history;
+  pushSample(history, 1000, 1.0);
+  pushSample(history, 2000, 2.0);
+  // Stamps have to increase, the late sample is dropped
+  pushSample(history, 1500, 9.0);
+  EXPECT_EQ(history.size(), 2u);
+  StateSample sample;
+  ASSERT_TRUE(history.sample(0, sample));
+  EXPECT_FLOAT_EQ(sample.q[0], 1.0f);
+  ASSERT_TRUE(history.sample(5000, sample));
+  EXPECT_FLOAT_EQ(sample.q[0], 2.0f);
+  // Older samples than the capacity are overwritten
+  for (int64_t i = 3; i < 3 + static_cast<int64_t>(StateHistory::CAPACITY); i++) {
+    pushSample(history, i * 1000, static_cast<double>(i));
+  }
+  EXPECT_EQ(history.size(), StateHistory::CAPACITY);
+  ASSERT_TRUE(history.sample(0, sample));
+  EXPECT_FLOAT_EQ(sample.q[0], 3.0f);
+}
+
+// Sample i carries the value i in every field, a torn or mismatched copy breaks the linear
+// relation between the stamp and the values
+TEST(StateHistory, ConcurrentReadsAreConsistent)
+{
+  using namespace unitree_a1_neural_control;
+  constexpr int64_t SAMPLES = 20000;
+  constexpr int64_t PERIOD_NS = 1000;
+  StateHistory history;
+  pushSample(history, PERIOD_NS, 1.0);
+  std::atomic<bool> done{false};
+  std::thread writer([&]() {
+      for (int64_t i = 2; i <= SAMPLES; i++) {
+        pushSample(history, i * PERIOD_NS, static_cast<double>(i));
+      }
+      done.store(true);
+    });
+  uint64_t reads = 0;
+  int64_t target = PERIOD_NS;
+  while (!done.load()) {
+    StateSample sample;
+    if (!history.sample(target, sample)) {
+      continue;
+    }
+    reads++;
+    // Held at the oldest sample when the target fell out of the ring
+    const double expected = static_cast<double>(sample.stamp_ns) / PERIOD_NS;
+    ASSERT_NEAR(sample.angular_velocity[0], expected, 1e-9);
+    ASSERT_NEAR(sample.q[0], expected, 1e-3 * expected);
+    ASSERT_NEAR(sample.tau_est[JOINT_COUNT - 1], expected, 1e-3 * expected);
+    target += PERIOD_NS / 3;
+  }
+  writer.join();
+  EXPECT_GT(reads, 0u);
+}
@@ -0,0 +1,68 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "unitree_a1_neural_control/triple_buffer.hpp"
+
+TEST(TripleBuffer, ReaderSeesTheLatestPublishedValue)
+{
+  using unitree_a1_neural_control::TripleBuffer;
+  TripleBuffer<int> buffer(7);
+  EXPECT_EQ(buffer.read(), 7);
+  buffer.write(1);
+  buffer.write(2);
+  EXPECT_EQ(buffer.read(), 2);
+  // Nothing new, the reader keeps its value
+  EXPECT_EQ(buffer.read(), 2);
+  buffer.writeBuffer() = 3;
+  EXPECT_EQ(buffer.read(), 2);
+  buffer.publish();
+  EXPECT_EQ(buffer.read(), 3);
+}
+
+// Every value is written whole, a torn read would mix two of them
+TEST(TripleBuffer, ConcurrentReadsAreNeverTorn)
+{
+  using unitree_a1_neural_control::TripleBuffer;
+  using Value = std::array<uint64_t, 32>;
+  constexpr uint64_t WRITES = 100000;
+  TripleBuffer<Value> buffer;
+  std::atomic<bool> done{false};
+  std::thread writer([&]() {
+      for (uint64_t i = 1; i <= WRITES; i++) {
+        buffer.writeBuffer().fill(i);
+        buffer.publish();
+      }
+      done.store(true);
+    });
+  uint64_t last = 0;
+  bool finished = false;
+  while (!finished) {
+    finished = done.load();
+    const Value & value = buffer.read();
+    for (const auto word : value) {
+      ASSERT_EQ(word, value[0]);
+    }
+    // Values only move forward
+    ASSERT_GE(value[0], last);
+    last = value[0];
+  }
+  writer.join();
+  EXPECT_EQ(buffer.read()[0], WRITES);
+}
@@ -0,0 +1,50 @@
+// Copyright 2023 Maciej Krupka
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "policy_fixtures.hpp"
+
+// Callers that never feed updateSensors still get foot contact from their own message
+TEST(UnitreeNeuralControl, ContactFromMessageWithoutSensorSamples)
+{
+  using namespace unitree_a1_neural_control;
+  const auto policy = writeConstantPolicy("controller_test_policy", 0.0f);
+  UnitreeNeuralControl controller(policy, 20, Robot::NOMINAL);
+  auto goal = std::make_shared<geometry_msgs::msg::TwistStamped>();
+  auto state = std::make_shared<unitree_a1_legged_msgs::msg::LowState>();
+  state->imu.orientation.w = 1.0;
+  state->foot_force.front_right = 100;
+  std::vector<float> input, output;
+  for (int tick = 0; tick < 3; tick++) {
+    controller.modelForward(goal, state);
+    controller.getInputAndOutput(input, output);
+    // Contact slots are FL, FR, RL, RR
+    EXPECT_EQ(input[OBS_FOOT_CONTACT + 0], 0.0f);
+    EXPECT_EQ(input[OBS_FOOT_CONTACT + 1], 1.0f);
+    EXPECT_EQ(input[OBS_FOOT_CONTACT + 2], 0.0f);
+    EXPECT_EQ(input[OBS_FOOT_CONTACT + 3], 0.0f);
+    // Cycles are FR, FL, RR, RL, the loaded foot never counts up
+    EXPECT_EQ(input[OBS_CYCLES_SINCE_CONTACT + 0], 0.0f);
+    EXPECT_EQ(input[OBS_CYCLES_SINCE_CONTACT + 1], static_cast<float>(tick + 1));
+  }
+  state->foot_force.front_right = 0;
+  controller.modelForward(goal, state);
+  controller.getInputAndOutput(input, output);
+  EXPECT_EQ(input[OBS_FOOT_CONTACT + 1], 0.0f);
+  std::remove(policy.c_str());
+}